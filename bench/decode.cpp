@@ -0,0 +1,48 @@
+/* MessagePack decoding benchmark */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SimpleRPC.h"
+#include "backend/MessagePackBackend.h"
+
+static SimpleRPC::Variant payload(size_t rows)
+{
+    std::vector<std::map<std::string, std::vector<int>>> tables;
+    std::vector<std::string> names;
+
+    /* mixed containers, strings and integers of every width */
+    for (size_t i = 0; i < rows; i++)
+    {
+        std::map<std::string, std::vector<int>> table;
+        table["small"] = std::vector<int>(16, static_cast<int>(i % 100));
+        table["large"] = std::vector<int>(16, static_cast<int>(i * 100003));
+        tables.push_back(std::move(table));
+        names.push_back("row-" + std::to_string(i));
+    }
+
+    return SimpleRPC::Variant::array(tables, names);
+}
+
+int main(int argc, char **argv)
+{
+    size_t rows = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    size_t rounds = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 10;
+
+    SimpleRPC::Backends::MessagePackBackend backend;
+    SimpleRPC::ByteSeq data = backend.assemble(payload(rows));
+    auto start = std::chrono::steady_clock::now();
+
+    /* decode the same message over and over */
+    for (size_t i = 0; i < rounds; i++)
+    {
+        SimpleRPC::ByteSeq copy(data.data(), data.length());
+        backend.parse(std::move(copy));
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu bytes x %zu rounds\n", data.length(), rounds);
+    printf("decode : %10.2f MB/s\n", data.length() * rounds / seconds / 1e6);
+    return 0;
+}
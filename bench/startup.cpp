@@ -0,0 +1,38 @@
+/* Startup benchmark, registers a lot of generated classes */
+
+#include <chrono>
+#include <stdio.h>
+
+/* runs before any class in this file is registered */
+static const auto StartTime = std::chrono::steady_clock::now();
+
+#include "SimpleRPC.h"
+#include "StartupClasses.h"
+
+static double elapsed(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+}
+
+int main()
+{
+    double init = elapsed(StartTime);
+    auto start = std::chrono::steady_clock::now();
+
+    /* the first lookup freezes the class table and builds one class */
+    BenchClass0 first;
+    double lookup = elapsed(start);
+
+    /* build every other class */
+    start = std::chrono::steady_clock::now();
+#define BENCH_CLASS(type) { type object [[gnu::unused]]; }
+    BENCH_CLASSES(BENCH_CLASS)
+#undef BENCH_CLASS
+    double all = elapsed(start);
+
+    printf("%d classes\n", BENCH_CLASS_COUNT);
+    printf("static initialization : %10.1f us\n", init);
+    printf("first lookup          : %10.1f us\n", lookup);
+    printf("build all classes     : %10.1f us\n", all);
+    return 0;
+}
@@ -0,0 +1,80 @@
+/* Size-classed buffer pool with thread-local caches */
+
+#ifndef SIMPLERPC_BUFFERPOOL_H
+#define SIMPLERPC_BUFFERPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace SimpleRPC
+{
+/** every block has a hidden header in front of it, which records where it came from and it's reference count
+ *  capacities are powers of two from 32 bytes to 1 MiB, larger blocks go to `malloc` directly
+ *  blocks beyond the map threshold are mapped from the system, and grown by `mremap` without copying
+ *  released blocks are cached by the releasing thread, and reused by later allocations of the same class
+ **/
+class BufferPool final
+{
+    BufferPool() = delete;
+
+public:
+    static const size_t MinClassShift = 5;
+    static const size_t MaxClassShift = 20;
+    static const size_t ClassCount = MaxClassShift - MinClassShift + 1;
+
+public:
+    struct Stats
+    {
+        size_t hits;        /* served from caches */
+        size_t misses;      /* served by the slab or `malloc` */
+        size_t mapped;      /* mapped from the system, anonymous or files */
+        size_t oversized;   /* larger than the largest class, always `malloc` */
+        size_t slabUsed;    /* bytes carved from the slab */
+        size_t slabSize;    /* bytes reserved for the slab */
+
+    public:
+        double hitRate(void) const { return (hits + misses) ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+
+    };
+
+public:
+    /* `capacity` receives the usable size of the block, which is at least `size` */
+    static void *allocate(size_t size, size_t &capacity);
+    static void *reallocate(void *mem, size_t size, size_t &capacity);
+
+public:
+    /* blocks start with one reference, `release` drops one and frees the block with the last one */
+    static void retain(void *mem) noexcept;
+    static void release(void *mem) noexcept;
+
+public:
+    static bool isShared(const void *mem) noexcept;
+    static bool isReadOnly(const void *mem) noexcept;
+    static size_t capacityOf(const void *mem) noexcept;
+
+public:
+    /* file descriptor that holds the payload of mapped blocks, for `sendfile`, or -1 if none */
+    static int descriptorOf(const void *mem, off_t &offset) noexcept;
+
+public:
+    /* blocks not less than `size` bytes are mapped, 64 MiB by default */
+    static void setMapThreshold(size_t size);
+
+public:
+    /* map `size` bytes of a file as a read-only block, the descriptor can be closed afterwards */
+    static void *mapFile(int fd, size_t size, size_t &capacity);
+
+public:
+    /* statistics of all threads, including the exited ones */
+    static Stats stats(void);
+
+public:
+    /* reserve a slab backed by huge pages if possible, blocks are carved from it before falling back to `malloc`
+     * can only be reserved once, returns whether the slab is available */
+    static bool reserveSlab(size_t size);
+
+};
+}
+
+#endif /* SIMPLERPC_BUFFERPOOL_H */
@@ -0,0 +1,125 @@
+/* Segmented byte sequence for scatter-gather I/O */
+
+#ifndef SIMPLERPC_BYTEROPE_H
+#define SIMPLERPC_BYTEROPE_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#include "ByteSeq.h"
+
+namespace SimpleRPC
+{
+class ByteRope
+{
+    /* data is in [begin, end) of each segment, segments are never moved or reallocated */
+    struct Segment
+    {
+        char *mem;
+        size_t begin;
+        size_t end;
+        size_t capacity;
+    };
+
+private:
+    size_t _length = 0;
+    size_t _segmentSize;
+    std::deque<Segment> _segments;
+
+public:
+   ~ByteRope() { clear(); }
+    explicit ByteRope(size_t segmentSize = 4096) : _segmentSize(segmentSize) {}
+
+private:
+    ByteRope(const ByteRope &) = delete;
+    ByteRope &operator=(const ByteRope &) = delete;
+
+public:
+    ByteRope(ByteRope &&other) : _segmentSize(other._segmentSize) { swap(other); }
+    ByteRope &operator=(ByteRope &&other) { swap(other); return *this; }
+
+public:
+    void swap(ByteRope &other);
+
+public:
+    size_t length(void) const { return _length; }
+    size_t segments(void) const { return _segments.size(); }
+    size_t segmentSize(void) const { return _segmentSize; }
+
+public:
+    void clear(void);
+    void consume(size_t size);
+
+public:
+    /* existing data is never copied */
+    void append(const void *data, size_t size);
+    void prepend(const void *data, size_t size);
+
+public:
+    void append(const char *data)        { append(data, strlen(data)); }
+    void append(const ByteSeq &data)     { append(data.data(), data.length()); }
+    void append(const std::string &data) { append(data.data(), data.length()); }
+
+public:
+    template <typename T>
+    void appendLE(const T &data)
+    {
+        append(&data, sizeof(T));
+    }
+
+public:
+    template <typename T>
+    void appendBE(const T &data)
+    {
+        char d[sizeof(T)];
+        const char *p = reinterpret_cast<const char *>(&data);
+        std::reverse_copy(p, p + sizeof(T), d);
+        append(d, sizeof(T));
+    }
+
+public:
+    template <typename T>
+    void prependLE(const T &data)
+    {
+        prepend(&data, sizeof(T));
+    }
+
+public:
+    template <typename T>
+    void prependBE(const T &data)
+    {
+        char d[sizeof(T)];
+        const char *p = reinterpret_cast<const char *>(&data);
+        std::reverse_copy(p, p + sizeof(T), d);
+        prepend(d, sizeof(T));
+    }
+
+public:
+    /* io vectors of the data, at most `limit` of them, for `writev` or `sendmsg` */
+    std::vector<struct iovec> iovecs(size_t limit = IOV_MAX) const;
+
+public:
+    /* scatter-gather I/O, returns the result of `writev` or `readv`, written bytes are consumed */
+    ssize_t writeTo(int fd);
+    ssize_t readFrom(int fd, size_t size);
+
+public:
+    /* copy into contiguous buffers */
+    ByteSeq toByteSeq(void) const;
+    std::string toString(void) const;
+    size_t copyTo(void *data, size_t size) const;
+
+private:
+    Segment &allocate(size_t capacity, bool front);
+
+};
+}
+
+#endif /* SIMPLERPC_BYTEROPE_H */
@@ -10,6 +10,9 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/types.h>
+
+#include "BufferPool.h"
 
 namespace SimpleRPC
 {
@@ -24,7 +27,7 @@ private:
 
 public:
     ByteSeq() {}
-   ~ByteSeq() { free(_mem); }
+   ~ByteSeq() { BufferPool::release(_mem); }
 
 public:
     explicit ByteSeq(size_t initSize) { preserve(initSize); }
@@ -46,18 +49,42 @@ public:
     void swap(ByteSeq &other);
 
 public:
-    char *data(void) const { return _readptr; }
+    /* slices share the buffer with their parents without copying, the buffer is copied on the first write to it */
+    ByteSeq slice(size_t offset, size_t size) const;
+    ByteSeq consumeSlice(size_t size);
+
+public:
+    /* maps the whole file read-only without reading it, the data is copied on the first write */
+    static ByteSeq mapFile(const std::string &path);
+
+public:
+    bool isShared(void) const { return BufferPool::isShared(_mem); }
+
+public:
+    /* returns the result of `sendfile` for mapped buffers, or `write` otherwise, written bytes are consumed */
+    ssize_t sendTo(int fd);
+
+public:
+    const char *data(void) const { return _readptr; }
     size_t length(void) const { return _length; }
     size_t capacity(void) const { return _capacity; }
 
+public:
+    /* for writing in place, shared or mapped buffers are copied first */
+    char *mutableData(void);
+
 public:
     void clear(void);
     void commit(size_t size) { _length += size; }
 
 public:
-    char *consume(size_t size);
+    const char *consume(size_t size);
     char *preserve(size_t size);
 
+public:
+    /* drop bytes from the end, keeping the first `length` bytes */
+    void truncate(size_t length);
+
 public:
     void append(const void *data, size_t size);
 
@@ -70,8 +97,10 @@ public:
     template <typename T>
     T nextLE(void)
     {
-        char *p = consume(sizeof(T));
-        return std::move(*reinterpret_cast<T *>(p));
+        /* data might not be aligned */
+        T r;
+        memcpy(&r, consume(sizeof(T)), sizeof(T));
+        return r;
     }
 
 public:
@@ -79,10 +108,8 @@ public:
     T nextBE(void)
     {
         T r;
-        char *p = consume(sizeof(T));
-        char *q = reinterpret_cast<char *>(&r);
-        std::reverse_copy(p, p + sizeof(T), q);
-        return std::move(r);
+        swapBytes<sizeof(T)>(&r, consume(sizeof(T)));
+        return r;
     }
 
 public:
@@ -98,11 +125,64 @@ public:
     void appendBE(const T &data)
     {
         char d[sizeof(T)];
-        const char *p = reinterpret_cast<const char *>(&data);
-        std::reverse_copy(p, p + sizeof(T), d);
+        swapBytes<sizeof(T)>(d, &data);
         append(d, sizeof(T));
     }
 
+public:
+    /* bulk versions for arrays of scalars */
+    template <typename T>
+    void nextLE(T *data, size_t count)
+    {
+        if (count)
+            memcpy(data, consume(sizeof(T) * count), sizeof(T) * count);
+    }
+
+public:
+    template <typename T>
+    void nextBE(T *data, size_t count)
+    {
+        if (count)
+            swapBytes(data, consume(sizeof(T) * count), sizeof(T), count);
+    }
+
+public:
+    template <typename T>
+    void appendLE(const T *data, size_t count)
+    {
+        append(data, sizeof(T) * count);
+    }
+
+public:
+    template <typename T>
+    void appendBE(const T *data, size_t count)
+    {
+        swapBytes(preserve(sizeof(T) * count), data, sizeof(T), count);
+        commit(sizeof(T) * count);
+    }
+
+public:
+    /* LEB128 varints, signed ones are zigzag encoded, at most 10 bytes each */
+    void appendVarUInt(uint64_t value);
+    void appendVarUInts(const uint64_t *data, size_t count);
+
+public:
+    void appendVarInt(int64_t value) { appendVarUInt(zigzag(value)); }
+    void appendVarInts(const int64_t *data, size_t count);
+
+public:
+    uint64_t nextVarUInt(void);
+    int64_t nextVarInt(void) { return unzigzag(nextVarUInt()); }
+
+public:
+    /* decode `count` varints in one go, 8 bytes at a time, nothing is consumed on errors */
+    void nextVarUInts(uint64_t *data, size_t count);
+    void nextVarInts(int64_t *data, size_t count);
+
+public:
+    static uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return static_cast<int64_t>((value >> 1) ^ (0 - (value & 1))); }
+
 public:
     std::string repr(void) const { return repr(_readptr, _length); }
     std::string hexdump(void) const { return hexdump(_readptr, _length); }
@@ -116,6 +196,33 @@ public:
     static std::string repr(const void *data, size_t size);
     static std::string hexdump(const void *data, size_t size);
 
+public:
+    /* reverse bytes of `count` elements of `size` bytes each, vectorized for 2, 4 and 8 bytes */
+    static void swapBytes(void *dest, const void *src, size_t size, size_t count);
+
+private:
+    template <size_t N>
+    static void swapBytes(void *dest, const void *src)
+    {
+        uint16_t v16;
+        uint32_t v32;
+        uint64_t v64;
+
+        /* `N` is a constant, all other branches are eliminated */
+        switch (N)
+        {
+            case 2  : memcpy(&v16, src, 2); v16 = __builtin_bswap16(v16); memcpy(dest, &v16, 2); break;
+            case 4  : memcpy(&v32, src, 4); v32 = __builtin_bswap32(v32); memcpy(dest, &v32, 4); break;
+            case 8  : memcpy(&v64, src, 8); v64 = __builtin_bswap64(v64); memcpy(dest, &v64, 8); break;
+            default :
+            {
+                const char *p = reinterpret_cast<const char *>(src);
+                std::reverse_copy(p, p + N, reinterpret_cast<char *>(dest));
+                break;
+            }
+        }
+    }
+
 };
 }
 
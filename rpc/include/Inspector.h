@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "Variant.h"
 #include "TypeInfo.h"
@@ -134,33 +135,41 @@ struct TypeRef
 
 /****** Parameter tuple expanders ******/
 
-template <size_t I, typename ... Args>
-struct ParamTupleImpl;
+template <typename T>
+struct ParamItem
+{
+    /* values are moved out of the argument pack if it's the only owner, mutable ones are patched back afterwards */
+    static T expand(const std::shared_ptr<Variant> &value) { return Variant::steal<T>(value); }
+};
 
-template <size_t I, typename Item, typename ... Items>
-struct ParamTupleImpl<I, Item, Items ...>
+template <typename T>
+struct ParamItem<T &>
 {
-    static constexpr std::tuple<Item, Items ...> expand(Variant &array)
-    {
-        return std::tuple_cat(
-            std::forward_as_tuple(array[I].get<Item>()),
-            ParamTupleImpl<I + 1, Items ...>::expand(array)
-        );
-    }
+    /* references still bind to the argument pack */
+    static T &expand(const std::shared_ptr<Variant> &value) { return value->get<T &>(); }
 };
 
-template <size_t I>
-struct ParamTupleImpl<I>
+template <typename ... Items>
+struct ParamTupleImpl
 {
-    static constexpr std::tuple<> expand(Variant &)
+    template <size_t ... I>
+    static std::tuple<Items ...> expand(Variant &array, std::index_sequence<I ...>)
     {
-        /* final recursion, no arguments left */
-        return std::tuple<>();
+        /* braced initialization evaluates in order, and every item is moved into the tuple exactly once */
+        const Variant::Array &items [[gnu::unused]] = array.internalArray();
+        return std::tuple<Items ...> { ParamItem<Items>::expand(items[I]) ... };
     }
 };
 
 template <typename ... Args>
-using ParamTuple = ParamTupleImpl<0, typename TypeRef<Args>::Type ...>;
+struct ParamTuple
+{
+    static std::tuple<typename TypeRef<Args>::Type ...> expand(Variant &array)
+    {
+        /* unpack by index, rather than concatenating tuples one item at a time */
+        return ParamTupleImpl<typename TypeRef<Args>::Type ...>::expand(array, std::index_sequence_for<Args ...>());
+    }
+};
 
 /****** Mutable parameter back-patcher ******/
 
@@ -255,6 +264,54 @@ struct BackPatcherImpl<I, Tuple>
 template <typename Tuple, typename ... Args>
 using BackPatcher = BackPatcherImpl<0, Tuple, Args ...>;
 
+/****** Generated serializer helpers ******/
+
+template <typename T>
+static inline void writeField(Variant::Object &object, const char *name, const T &value)
+{
+    /* same as what `Field` does, but without going through `std::function` */
+    object.emplace(name, std::make_shared<Variant>(value));
+}
+
+template <typename T>
+static inline void readField(const Variant *const *values, size_t &index, T &value)
+{
+    /* write the value directly back into field */
+    value = values[index++]->get<T>();
+}
+
+template <typename T>
+static inline std::enable_if_t<IsPackableField<T>::value> packField(char *&data, const T &value)
+{
+    memcpy(data, &value, sizeof(T));
+    data += sizeof(T);
+}
+
+template <typename T>
+static inline std::enable_if_t<IsPackableField<T>::value> unpackField(const char *&data, T &value)
+{
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+}
+
+static inline void unpackField(const char *&data, bool &value)
+{
+    /* any byte other than 0 or 1 is not a valid `bool` */
+    value = (*data++ != 0);
+}
+
+template <typename T>
+static inline std::enable_if_t<!IsPackableField<T>::value> packField(char *&, const T &)
+{
+    /* classes with such fields are never packed, this only keeps the generated code compiling */
+}
+
+template <typename T>
+static inline std::enable_if_t<!IsPackableField<T>::value> unpackField(const char *&, T &)
+{
+    /* classes with such fields are never packed, this only keeps the generated code compiling */
+}
+
 #pragma clang diagnostic pop
 }
 
@@ -316,8 +373,9 @@ public:
                     auto tuple = Internal::ParamTuple<Args ...>::expand(argv);
                     auto result = MetaFunction::invoke(static_cast<T *>(self), std::move(f), tuple);
 
-                    /* patch mutable arguments back into `argv` */
-                    Internal::BackPatcher<Tuple, Args ...>::patch(argv, std::move(tuple));
+                    /* patch mutable arguments back into `argv`, if any */
+                    if (Internal::HasMutableReference<Args ...>::value)
+                        Internal::BackPatcher<Tuple, Args ...>::patch(argv, std::move(tuple));
                     return std::move(result);
                 }
             ))
@@ -328,25 +386,30 @@ public:
     };
 
 public:
-    explicit Descriptor(const std::vector<MemberData> &members)
+    /* only registers the builder generated by `defineClass`, which is called on the first lookup of this class */
+    explicit Descriptor() { Registry::addClass(typeid(T).name(), &T::__SimpleRPC_describe); }
+
+public:
+    static std::shared_ptr<Registry::Meta> build(const std::vector<MemberData> &members, const Registry::Meta::Codec &codec = Registry::Meta::Codec())
     {
-        Registry::Meta::FieldMap fields;
+        Registry::Meta::FieldList fields;
         Registry::Meta::MethodMap methods;
 
         for (const MemberData &info : members)
         {
             if (!info.isMethod)
-                fields.emplace(info.field->name(), std::move(info.field));
+                fields.emplace_back(std::move(info.field));
             else
                 methods.emplace(info.method->signature(), std::move(info.method));
         }
 
-        Registry::addClass(std::make_shared<Registry::Meta>(
+        return std::make_shared<Registry::Meta>(
             Internal::TypeItem<T>::type().toSignature(),
             std::move(fields),
             std::move(methods),
-            []{ return static_cast<Serializable *>(new T); }
-        ));
+            []{ return static_cast<Serializable *>(new T); },
+            codec
+        );
     }
 };
 }
@@ -5,14 +5,18 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <unordered_map>
 
 #include <cxxabi.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <sys/types.h>
 
 namespace SimpleRPC
 {
 /****** Reflection registry ******/
+class Variant;
 struct Field;
 struct Method;
 struct Serializable;
@@ -25,40 +29,111 @@ struct Registry
         Meta &operator=(const Meta &) = delete;
 
     public:
+        typedef std::vector<std::shared_ptr<Field>> FieldList;
         typedef std::unordered_map<std::string, std::shared_ptr<Field>> FieldMap;
         typedef std::unordered_map<std::string, std::shared_ptr<Method>> MethodMap;
 
     public:
         typedef Serializable *(* Constructor)(void);
 
+    public:
+        /* generated by `defineClass`, the deserializer takes one value per field, in the order of `fieldList()` */
+        typedef Variant (* Serializer)(const Serializable *self);
+        typedef void (* Deserializer)(Serializable *self, const Variant *const *values);
+
+    public:
+        /* packed records have every field in the order of `fieldList()`, in native byte order without padding */
+        typedef void (* Packer)(const Serializable *self, char *data);
+        typedef void (* Unpacker)(Serializable *self, const char *data);
+
+    public:
+        /* value-initialized `Codec()` has nothing generated */
+        struct Codec
+        {
+            Serializer serializer;
+            Deserializer deserializer;
+
+        public:
+            /* only for classes with fixed-width primitive fields */
+            Packer packer;
+            Unpacker unpacker;
+            size_t packedSize;
+
+        };
+
     private:
         FieldMap _fields;
+        FieldList _fieldList;
         MethodMap _methods;
         Constructor _constructor;
 
+    private:
+        /* perfect hash of field names, maps to indexes of `_fieldList`, -1 for empty buckets */
+        uint64_t _seed;
+        std::vector<int32_t> _index;
+
+    private:
+        uint64_t _hash;
+        uint64_t _layout;
+
+    private:
+        Codec _codec;
+
     private:
         std::string _name;
 
     public:
-        explicit Meta() : _constructor(nullptr) {}
-        explicit Meta(std::string &&name, FieldMap &&fields, MethodMap &&methods, Constructor &&constructor) :
-            _name(std::move(name)), _fields(std::move(fields)), _methods(std::move(methods)), _constructor(std::move(constructor)) {}
+        explicit Meta() : _constructor(nullptr), _seed(0), _hash(0), _layout(0), _codec() {}
+        explicit Meta(
+            std::string    &&name,
+            FieldList      &&fields,
+            MethodMap      &&methods,
+            Constructor    &&constructor,
+            const Codec     &codec = Codec()
+        );
 
     public:
         Meta(Meta &&other)
         {
+            std::swap(_name, other._name);
+            std::swap(_hash, other._hash);
+            std::swap(_layout, other._layout);
+            std::swap(_seed, other._seed);
+            std::swap(_index, other._index);
             std::swap(_fields, other._fields);
+            std::swap(_fieldList, other._fieldList);
             std::swap(_methods, other._methods);
             std::swap(_constructor, other._constructor);
+            std::swap(_codec, other._codec);
         }
 
     public:
+        uint64_t hash(void) const { return _hash; }
         const std::string &name(void) const { return _name; }
 
     public:
         const FieldMap &fields(void) const { return _fields; }
+        const FieldList &fieldList(void) const { return _fieldList; }
         const MethodMap &methods(void) const { return _methods; }
 
+    public:
+        /* index of the field in `fieldList()`, or -1 if no such field */
+        ssize_t indexOf(const char *name, size_t length) const;
+        ssize_t indexOf(const std::string &name) const { return indexOf(name.data(), name.size()); }
+
+    public:
+        Serializer serializer(void) const { return _codec.serializer; }
+        Deserializer deserializer(void) const { return _codec.deserializer; }
+
+    public:
+        Packer packer(void) const { return _codec.packer; }
+        Unpacker unpacker(void) const { return _codec.unpacker; }
+        size_t packedSize(void) const { return _codec.packedSize; }
+
+    public:
+        /* hash of field names and types in order, peers must agree on it before exchanging packed records */
+        uint64_t layout(void) const { return _layout; }
+
     public:
         template <typename T> T *newInstance(void) const { return static_cast<T *>(_constructor()); }
 
@@ -78,6 +153,10 @@ public:
     typedef const Meta *MetaPtr;
     typedef const Meta &MetaClass;
 
+public:
+    /* generated by `defineClass`, builds the meta data of the class */
+    typedef std::shared_ptr<Meta> (* Builder)(void);
+
 private:
     Registry() = delete;
     ~Registry() = delete;
@@ -87,14 +166,23 @@ private:
     Registry &operator=(const Registry &) = delete;
 
 public:
-    static void addClass(std::shared_ptr<Meta> &&meta);
+    /* hash of class names, classes can be found by it without comparing names */
+    static uint64_t hashOf(const char *name, size_t length);
+    static uint64_t hashOf(const std::string &name) { return hashOf(name.data(), name.size()); }
+
+public:
+    /* classes are registered during static initialization with only their `typeid` name
+     * meta data is built on the first lookup of each class, lookups are lock-free once all classes are registered */
+    static void addClass(const char *type, Builder builder);
+
+public:
+    static MetaClass findClass(uint64_t hash);
     static MetaClass findClass(const std::string &name);
 
 };
 
 /****** Serializable object container ******/
 
-class Variant;
 struct Serializable
 {
     typedef Registry::Meta Meta;
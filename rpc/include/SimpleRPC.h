@@ -34,6 +34,13 @@ struct SerializableWrapper : public Serializable
 #define __SRPC_PROXY_DECL(r, data, elem)                BOOST_PP_CAT(__SRPC_PROXY_DECL_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
 #define __SRPC_MEMBER_DECL(r, data, elem)               BOOST_PP_CAT(__SRPC_MEMBER_DECL_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
 #define __SRPC_MEMBER_REFL(r, data, elem)               BOOST_PP_CAT(__SRPC_MEMBER_REFL_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_COUNT(r, data, elem)              BOOST_PP_CAT(__SRPC_MEMBER_COUNT_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_WRITE(r, data, elem)              BOOST_PP_CAT(__SRPC_MEMBER_WRITE_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_READ(r, data, elem)               BOOST_PP_CAT(__SRPC_MEMBER_READ_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_SIZE(r, data, elem)               BOOST_PP_CAT(__SRPC_MEMBER_SIZE_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_PACKABLE(r, data, elem)           BOOST_PP_CAT(__SRPC_MEMBER_PACKABLE_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_PACK(r, data, elem)               BOOST_PP_CAT(__SRPC_MEMBER_PACK_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
+#define __SRPC_MEMBER_UNPACK(r, data, elem)             BOOST_PP_CAT(__SRPC_MEMBER_UNPACK_, BOOST_PP_SEQ_ELEM(0, elem))(data, elem)
 
 #define defineClass(type, ...)                                                                                                  \
     struct type final : public ::SimpleRPC::SerializableWrapper<type>                                                           \
@@ -46,11 +53,61 @@ struct SerializableWrapper : public Serializable
             using ::SimpleRPC::Network::InvokeProxyAdapter<type>::InvokeProxyAdapter;                                           \
             BOOST_PP_SEQ_FOR_EACH(__SRPC_PROXY_DECL, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                               \
         };                                                                                                                      \
+                                                                                                                                \
+        static ::SimpleRPC::Variant __SimpleRPC_serialize(const ::SimpleRPC::Serializable *object)                              \
+        {                                                                                                                       \
+            const type *self [[gnu::unused]] = static_cast<const type *>(object);                                               \
+            ::SimpleRPC::Variant result(::SimpleRPC::Type::TypeCode::Object);                                                   \
+            ::SimpleRPC::Variant::Object &fields = result.internalObject();                                                     \
+                                                                                                                                \
+            fields.reserve(0 BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_COUNT, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)));          \
+            BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_WRITE, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                             \
+            return result;                                                                                                      \
+        }                                                                                                                       \
+                                                                                                                                \
+        static void __SimpleRPC_deserialize(                                                                                    \
+            ::SimpleRPC::Serializable *object,                                                                                  \
+            const ::SimpleRPC::Variant *const *values [[gnu::unused]])                                                          \
+        {                                                                                                                       \
+            size_t index [[gnu::unused]] = 0;                                                                                   \
+            type *self [[gnu::unused]] = static_cast<type *>(object);                                                           \
+            BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_READ, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                              \
+        }                                                                                                                       \
+                                                                                                                                \
+        static constexpr size_t __SimpleRPC_packedSize =                                                                        \
+            0 BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_SIZE, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__));                           \
+                                                                                                                                \
+        static constexpr bool __SimpleRPC_packable =                                                                            \
+            (__SimpleRPC_packedSize > 0)                                                                                        \
+            BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_PACKABLE, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__));                         \
+                                                                                                                                \
+        static void __SimpleRPC_pack(const ::SimpleRPC::Serializable *object, char *data [[gnu::unused]])                       \
+        {                                                                                                                       \
+            const type *self [[gnu::unused]] = static_cast<const type *>(object);                                               \
+            BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_PACK, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                              \
+        }                                                                                                                       \
+                                                                                                                                \
+        static void __SimpleRPC_unpack(::SimpleRPC::Serializable *object, const char *data [[gnu::unused]])                     \
+        {                                                                                                                       \
+            type *self [[gnu::unused]] = static_cast<type *>(object);                                                           \
+            BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_UNPACK, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                            \
+        }                                                                                                                       \
+                                                                                                                                \
+        static std::shared_ptr<::SimpleRPC::Registry::Meta> __SimpleRPC_describe(void)                                          \
+        {                                                                                                                       \
+            return ::SimpleRPC::Descriptor<type>::build({                                                                       \
+                BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_REFL, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                          \
+            }, {                                                                                                                \
+                &type::__SimpleRPC_serialize,                                                                                   \
+                &type::__SimpleRPC_deserialize,                                                                                 \
+                type::__SimpleRPC_packable ? &type::__SimpleRPC_pack : nullptr,                                                 \
+                type::__SimpleRPC_packable ? &type::__SimpleRPC_unpack : nullptr,                                               \
+                type::__SimpleRPC_packable ? type::__SimpleRPC_packedSize : 0,                                                  \
+            });                                                                                                                 \
+        }                                                                                                                       \
     };                                                                                                                          \
                                                                                                                                 \
-    static ::SimpleRPC::Descriptor<type> __SimpleRPC_Descriptor_ ## type ## _DO_NOT_TOUCH_THIS_VARIABLE__ [[gnu::unused]] ({    \
-        BOOST_PP_SEQ_FOR_EACH(__SRPC_MEMBER_REFL, type, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))                                  \
-    });
+    static ::SimpleRPC::Descriptor<type> __SimpleRPC_Descriptor_ ## type ## _DO_NOT_TOUCH_THIS_VARIABLE__ [[gnu::unused]];
 
 #define __SRPC_METHOD_ARG_LIST(elem)                    BOOST_PP_SEQ_ENUM(BOOST_PP_SEQ_ELEM(3, elem))
 #define __SRPC_METHOD_SIG_TYPE(type, elem)              BOOST_PP_SEQ_ELEM(1, elem) (type::*)(__SRPC_METHOD_ARG_LIST(elem))
@@ -58,6 +115,7 @@ struct SerializableWrapper : public Serializable
 #define __SRPC_FIELD_SIG_CAST(type, elem)               static_cast<type *>(nullptr)->BOOST_PP_SEQ_ELEM(1, elem)
 #define __SRPC_METHOD_SIG_CAST(type, elem)              static_cast<__SRPC_METHOD_SIG_TYPE(type, elem)>(&type::BOOST_PP_SEQ_ELEM(2, elem))
 
+#define __SRPC_PROXY_METHOD(type, elem)                 static_cast<__SRPC_METHOD_SIG_TYPE(type, elem)>(nullptr), BOOST_PP_STRINGIZE(BOOST_PP_SEQ_ELEM(2, elem))
 #define __SRPC_PROXY_ARG_ITEM(i, name, type)            BOOST_PP_IF(BOOST_PP_IS_EMPTY(type), BOOST_PP_EMPTY(), type BOOST_PP_CAT(name, BOOST_PP_SUB(i, 1)))
 #define __SRPC_PROXY_ARG_LIST(elem)                     BOOST_PP_SEQ_ENUM(BOOST_PP_SEQ_TRANSFORM(__SRPC_PROXY_ARG_ITEM, _, BOOST_PP_SEQ_ELEM(3, elem)))
 
@@ -69,10 +127,10 @@ struct SerializableWrapper : public Serializable
 #define __SRPC_PROXY_DECL_FUNC(type, elem)                                                                      \
     BOOST_PP_SEQ_ELEM(1, elem) BOOST_PP_SEQ_ELEM(2, elem) (__SRPC_PROXY_ARG_LIST(elem))                         \
     {                                                                                                           \
-        return ::SimpleRPC::Network::InvokeProxyAdapter<type>::invoke<BOOST_PP_SEQ_ELEM(1, elem)> BOOST_PP_IF(  \
+        return ::SimpleRPC::Network::InvokeProxyAdapter<type>::invoke BOOST_PP_IF(                              \
             BOOST_PP_IS_EMPTY(BOOST_PP_SEQ_HEAD(BOOST_PP_SEQ_ELEM(3, elem))),                                   \
-            (BOOST_PP_STRINGIZE(BOOST_PP_SEQ_ELEM(2, elem))),                                                   \
-            (BOOST_PP_STRINGIZE(BOOST_PP_SEQ_ELEM(2, elem)), __SRPC_PROXY_CALL_LIST(elem))                      \
+            (__SRPC_PROXY_METHOD(type, elem)),                                                                  \
+            (__SRPC_PROXY_METHOD(type, elem), __SRPC_PROXY_CALL_LIST(elem))                                     \
         );                                                                                                      \
     }
 
@@ -84,6 +142,36 @@ struct SerializableWrapper : public Serializable
 #define __SRPC_MEMBER_REFL_VAR(type, elem)              ::SimpleRPC::Descriptor<type>::MemberData(BOOST_PP_STRINGIZE(BOOST_PP_SEQ_ELEM(1, elem)), __SRPC_FIELD_SIG_CAST(type, elem)),
 #define __SRPC_MEMBER_REFL_FUNC(type, elem)             ::SimpleRPC::Descriptor<type>::MemberData(BOOST_PP_STRINGIZE(BOOST_PP_SEQ_ELEM(2, elem)), __SRPC_METHOD_SIG_CAST(type, elem)),
 
+/* generated serializers are unrolled over fields, without going through `Field` */
+#define __SRPC_MEMBER_COUNT_RAW(type, elem)
+#define __SRPC_MEMBER_COUNT_VAR(type, elem)             + 1
+#define __SRPC_MEMBER_COUNT_FUNC(type, elem)
+
+#define __SRPC_MEMBER_WRITE_RAW(type, elem)
+#define __SRPC_MEMBER_WRITE_VAR(type, elem)             ::SimpleRPC::Internal::writeField(fields, BOOST_PP_STRINGIZE(BOOST_PP_SEQ_ELEM(1, elem)), self->BOOST_PP_SEQ_ELEM(1, elem));
+#define __SRPC_MEMBER_WRITE_FUNC(type, elem)
+
+#define __SRPC_MEMBER_READ_RAW(type, elem)
+#define __SRPC_MEMBER_READ_VAR(type, elem)              ::SimpleRPC::Internal::readField(values, index, self->BOOST_PP_SEQ_ELEM(1, elem));
+#define __SRPC_MEMBER_READ_FUNC(type, elem)
+
+/* classes with only fixed-width primitive fields are also packed into records */
+#define __SRPC_MEMBER_SIZE_RAW(type, elem)
+#define __SRPC_MEMBER_SIZE_VAR(type, elem)              + sizeof(decltype(BOOST_PP_SEQ_ELEM(1, elem)))
+#define __SRPC_MEMBER_SIZE_FUNC(type, elem)
+
+#define __SRPC_MEMBER_PACKABLE_RAW(type, elem)
+#define __SRPC_MEMBER_PACKABLE_VAR(type, elem)          && ::SimpleRPC::Internal::IsPackableField<decltype(BOOST_PP_SEQ_ELEM(1, elem))>::value
+#define __SRPC_MEMBER_PACKABLE_FUNC(type, elem)
+
+#define __SRPC_MEMBER_PACK_RAW(type, elem)
+#define __SRPC_MEMBER_PACK_VAR(type, elem)              ::SimpleRPC::Internal::packField(data, self->BOOST_PP_SEQ_ELEM(1, elem));
+#define __SRPC_MEMBER_PACK_FUNC(type, elem)
+
+#define __SRPC_MEMBER_UNPACK_RAW(type, elem)
+#define __SRPC_MEMBER_UNPACK_VAR(type, elem)            ::SimpleRPC::Internal::unpackField(data, self->BOOST_PP_SEQ_ELEM(1, elem));
+#define __SRPC_MEMBER_UNPACK_FUNC(type, elem)
+
 #define defineRaw(stmt)                                 (RAW)(stmt)
 #define defineField(type, name)                         (VAR)(name)(type name = type())
 #define declareMethod(ret, name, args)                  (FUNC)(ret)(name)(BOOST_PP_TUPLE_TO_SEQ(args))
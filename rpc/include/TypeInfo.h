@@ -490,6 +490,17 @@ struct IsMutableObjectReference
         IsMutableReference<T>::value;
 };
 
+template <typename ... Args>
+struct HasMutableReference : public std::false_type {};
+
+template <typename Arg, typename ... Args>
+struct HasMutableReference<Arg, Args ...>
+{
+    static const bool value =
+        IsMutableReference<Arg>::value ||
+        HasMutableReference<Args ...>::value;
+};
+
 template <typename T, typename Integer>
 struct IsSignedIntegerLike
 {
@@ -510,6 +521,19 @@ struct IsUnsignedIntegerLike
         (sizeof(std::decay_t<T>) == sizeof(Integer));
 };
 
+/* fixed-width primitives, which can be copied into packed records as they are */
+template <typename T>
+struct IsPackableField
+{
+    static const bool value =
+        std::is_arithmetic<T>::value &&
+        (sizeof(T) <= sizeof(uint64_t));
+};
+
+/* classes with only packable fields, detected by `defineClass` */
+template <typename T, typename = void> struct IsPackable                                                   : public std::false_type {};
+template <typename T>                  struct IsPackable<T, std::enable_if_t<T::__SimpleRPC_packable>> : public std::true_type  {};
+
 #pragma clang diagnostic pop
 }
 }
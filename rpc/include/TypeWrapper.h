@@ -3,17 +3,18 @@
 #ifndef SIMPLERPC_TYPEWRAPPER_H
 #define SIMPLERPC_TYPEWRAPPER_H
 
-#include <memory>
+#include <utility>
 #include <type_traits>
 
 namespace SimpleRPC
 {
 namespace Internal
 {
+/* holds the value inline, so the argument tuple owns it without any extra allocation */
 template <typename T>
 class TypeWrapper final
 {
-    std::shared_ptr<T> _value;
+    T _value;
 
 public:
     typedef T Type;
@@ -21,8 +22,11 @@ public:
     static_assert(!std::is_reference<T>::value, "`T` must not be references");
 
 public:
-    T &operator*() const { return *_value; }
-    TypeWrapper(std::shared_ptr<T> &&value) : _value(std::move(value)) {}
+    T &operator*() { return _value; }
+    const T &operator*() const { return _value; }
+
+public:
+    TypeWrapper(T &&value) : _value(std::move(value)) {}
 
 };
 
@@ -3,6 +3,8 @@
 #ifndef SIMPLERPC_VARIANT_H
 #define SIMPLERPC_VARIANT_H
 
+#include <mutex>
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
@@ -27,7 +29,8 @@ struct VariantHashKey final
     std::shared_ptr<Variant> key;
 
 public:
-    VariantHashKey(Variant &&key) : key(std::make_shared<Variant>(key)) {}
+    VariantHashKey(Variant &&key) : key(std::make_shared<Variant>(std::move(key))) {}
+    explicit VariantHashKey(std::shared_ptr<Variant> &&key) : key(std::move(key)) {}
 
 public:
     bool operator==(const VariantHashKey &other) const;
@@ -77,11 +80,61 @@ public:
     typedef std::unordered_map<std::string, std::shared_ptr<Variant>> Object;
     typedef std::unordered_map<VariantHashKey, std::shared_ptr<Variant>, VariantHashKey::Hash> Map;
 
+public:
+    /* decoder for deferred compound values, used by backends that decode lazily */
+    struct Loader
+    {
+        virtual ~Loader() {}
+        virtual void load(Variant &value) const = 0;
+    };
+
+public:
+    /* packed records of classes with only fixed-width primitive fields, objects hold one record, arrays hold `count` */
+    struct PackedLoader : public Loader
+    {
+        size_t count;
+        ByteSeq data;
+        Registry::MetaPtr meta;
+
+    public:
+        explicit PackedLoader(Registry::MetaPtr meta, ByteSeq &&data, size_t count) :
+            count(count), data(std::move(data)), meta(meta) {}
+
+    public:
+        /* objects are materialized into fields, array items become packed objects sharing the same buffer */
+        virtual void load(Variant &value) const override;
+
+    };
+
+private:
+    /* items of maps, arrays and objects, kept out of line so scalar values stay small */
+    struct Compound
+    {
+        Map map;
+        Array array;
+        Object object;
+    };
+
 private:
-    Map _map;
-    Array _array;
-    Object _object;
     std::string _string;
+    std::unique_ptr<Compound> _compound;
+
+private:
+    /* deferred values only, the loader is kept after loading for `packed()` */
+    struct Lazy
+    {
+        std::mutex lock;
+        std::atomic<bool> loaded;
+        std::shared_ptr<const Loader> loader;
+
+    public:
+        explicit Lazy(const std::shared_ptr<const Loader> &loader) : loaded(false), loader(loader) {}
+
+    };
+
+private:
+    /* `nullptr` for values that are decoded eagerly, which keeps them free of any locking */
+    std::unique_ptr<Lazy> _lazy;
 
 public:
     enum class ArrayElementType
@@ -98,6 +151,7 @@ private:
 public:
     explicit Variant() = default;
     explicit Variant(const Type::TypeCode &type) : _type(type) {}
+    explicit Variant(const Type::TypeCode &type, std::shared_ptr<const Loader> &&loader) : _lazy(loader ? new Lazy(loader) : nullptr), _type(type) {}
 
 public:
     Variant(int8_t  value) : _type(Type::TypeCode::Int8 ), _s8 (value) {}
@@ -121,17 +175,22 @@ public:
 public:
     Variant(const char        *value) : _type(Type::TypeCode::String), _string(value) {}
     Variant(const std::string &value) : _type(Type::TypeCode::String), _string(value) {}
+    Variant(std::string      &&value) : _string(std::move(value)), _type(Type::TypeCode::String) {}
 
 public:
     template <typename T>
     Variant(const std::vector<T> &value) : _type(Type::TypeCode::Array)
     {
+        /* records of packable classes are packed into one block */
+        if (packArray(value, Internal::IsPackable<T>()))
+            return;
+
         /* reserve space to prevent frequent malloc */
-        _array.reserve(value.size());
+        compound().array.reserve(value.size());
 
         /* append every item */
         for (const auto &item : value)
-            _array.push_back(std::make_shared<Variant>(item));
+            compound().array.push_back(std::make_shared<Variant>(item));
 
         /* check for element type, these `if` statements will be optimized compile time */
         if (Internal::IsSignedIntegerLike<T, int8_t>::value)
@@ -147,12 +206,12 @@ public:
     Variant(const std::map<K, V> &value) : _type(Type::TypeCode::Map)
     {
         /* reserve space to prevent frequent malloc */
-        _map.reserve(value.size());
+        compound().map.reserve(value.size());
 
         /* append every item */
         for (const auto &item : value)
         {
-            _map.emplace(
+            compound().map.emplace(
                 VariantHashKey(Variant(item.first)),
                 std::make_shared<Variant>(item.second)
             );
@@ -164,12 +223,12 @@ public:
     Variant(const std::unordered_map<K, V> &value) : _type(Type::TypeCode::Map)
     {
         /* reserve space to prevent frequent malloc */
-        _map.reserve(value.size());
+        compound().map.reserve(value.size());
 
         /* append every item */
         for (const auto &item : value)
         {
-            _map.emplace(
+            compound().map.emplace(
                 VariantHashKey(Variant(item.first)),
                 std::make_shared<Variant>(item.second)
             );
@@ -181,21 +240,46 @@ public:
     Variant(const T &value) : _type(Type::TypeCode::Object) { assign(value.serialize()); }
 
 public:
-    Variant(Variant &&other)      { swap(other);   }
     Variant(const Variant &other) { assign(other); }
+    Variant(Variant &&other) :
+        _string     (std::move(other._string)),
+        _compound   (std::move(other._compound)),
+        _lazy       (std::move(other._lazy)),
+        _type       (other._type),
+        _itemType   (other._itemType)
+    {
+        /* decoders move every value at least once, so only take what other has instead of swapping */
+        memcpy(_buffer, other._buffer, sizeof(_buffer));
+        other._type = Type::TypeCode::Void;
+    }
 
 public:
-    Variant &operator=(Variant &&other)      { swap(other);   return *this; }
     Variant &operator=(const Variant &other) { assign(other); return *this; }
+    Variant &operator=(Variant &&other)
+    {
+        /* moving into itself */
+        if (this == &other)
+            return *this;
+
+        _type = other._type;
+        _lazy = std::move(other._lazy);
+        _string = std::move(other._string);
+        _compound = std::move(other._compound);
+        _itemType = other._itemType;
+
+        /* take other's union, and leave it empty */
+        memcpy(_buffer, other._buffer, sizeof(_buffer));
+        other._type = Type::TypeCode::Void;
+        return *this;
+    }
 
 public:
     void swap(Variant &other)
     {
-        std::swap(_map, other._map);
         std::swap(_type, other._type);
-        std::swap(_array, other._array);
-        std::swap(_object, other._object);
+        std::swap(_lazy, other._lazy);
         std::swap(_string, other._string);
+        std::swap(_compound, other._compound);
 
         /* copy from other's buffer, then clear it */
         memcpy(_buffer, other._buffer, sizeof(_buffer));
@@ -205,18 +289,163 @@ public:
 public:
     void assign(const Variant &other)
     {
-        _map = other._map;
+        /* assigning to itself */
+        if (this == &other)
+            return;
+
+        /* another thread might be loading it, wait for that to finish */
+        std::unique_lock<std::mutex> lock;
+        if (other._lazy && (loading() != &other))
+            lock = std::unique_lock<std::mutex>(other._lazy->lock);
+
         _type = other._type;
-        _array = other._array;
-        _object = other._object;
         _string = other._string;
+        _compound.reset(other._compound ? new Compound(*other._compound) : nullptr);
+
+        /* copies that are not loaded yet share the loader, but load on their own */
+        if (other._lazy && !other._lazy->loaded.load(std::memory_order_relaxed))
+            _lazy.reset(new Lazy(other._lazy->loader));
+        else
+            _lazy.reset();
 
         /* copy from other union */
         memcpy(_buffer, other._buffer, sizeof(_buffer));
     }
 
+private:
+    Compound &compound(void)
+    {
+        /* created on first use */
+        if (!_compound)
+            _compound.reset(new Compound);
+
+        return *_compound;
+    }
+
+private:
+    const Compound &compound(void) const
+    {
+        /* containers that never had any items */
+        static const Compound empty;
+        return _compound ? *_compound : empty;
+    }
+
+private:
+    static const Variant *&loading(void)
+    {
+        /* the variant that this thread is loading, loaders access it's containers while filling them */
+        static thread_local const Variant *instance = nullptr;
+        return instance;
+    }
+
+private:
+    void load(void) const
+    {
+        /* eager values, or loaded already */
+        if (_lazy && !_lazy->loaded.load(std::memory_order_acquire))
+            loadDeferred();
+    }
+
+private:
+    void loadDeferred(void) const
+    {
+        /* being filled by this thread */
+        if (loading() == this)
+            return;
+
+        /* concurrent readers of the same variant wait for the first one */
+        std::lock_guard<std::mutex> _(_lazy->lock);
+        Variant &self = const_cast<Variant &>(*this);
+        const Variant *outer = loading();
+
+        /* loaded by another thread while waiting */
+        if (_lazy->loaded.load(std::memory_order_relaxed))
+            return;
+
+        try
+        {
+            loading() = this;
+            _lazy->loader->load(self);
+            loading() = outer;
+        }
+        catch (...)
+        {
+            /* drop partial results, it stays unloaded so later reads fail again rather than seeing truncated data */
+            loading() = outer;
+            self._compound.reset();
+            throw;
+        }
+
+        /* publish the containers */
+        _lazy->loaded.store(true, std::memory_order_release);
+    }
+
 public:
+    bool isLoaded(void) const { return !_lazy || _lazy->loaded.load(std::memory_order_acquire); }
     Type::TypeCode type(void) const { return _type; }
+
+public:
+    /* packed records that are not materialized yet, or `nullptr` */
+    const PackedLoader *packed(void) const { return isLoaded() ? nullptr : dynamic_cast<const PackedLoader *>(_lazy->loader.get()); }
+
+private:
+    template <typename T>
+    static Registry::MetaPtr packedMeta(void)
+    {
+        /* look up only once for each class */
+        static Registry::MetaPtr meta = &Registry::findClass(Internal::TypeItem<T>::type().toSignature());
+        return meta;
+    }
+
+private:
+    template <typename T>
+    bool packArray(const std::vector<T> &value, std::true_type)
+    {
+        /* nothing to pack */
+        if (value.empty())
+            return false;
+
+        ByteSeq data;
+        char *p = data.preserve(T::__SimpleRPC_packedSize * value.size());
+
+        /* records are packed back to back */
+        for (const auto &item : value)
+        {
+            T::__SimpleRPC_pack(&item, p);
+            p += T::__SimpleRPC_packedSize;
+        }
+
+        data.commit(T::__SimpleRPC_packedSize * value.size());
+        _lazy.reset(new Lazy(std::make_shared<PackedLoader>(packedMeta<T>(), std::move(data), value.size())));
+        return true;
+    }
+
+private:
+    template <typename T>
+    bool unpackArray(std::vector<T> &array, std::true_type) const
+    {
+        const PackedLoader *loader = packed();
+
+        /* must be records of the same class */
+        if ((loader == nullptr) || (loader->meta != packedMeta<T>()))
+            return false;
+
+        /* copy records into items directly */
+        const char *p = loader->data.data();
+        array.resize(loader->count);
+
+        for (auto &item : array)
+        {
+            T::__SimpleRPC_unpack(&item, p);
+            p += T::__SimpleRPC_packedSize;
+        }
+
+        return true;
+    }
+
+private:
+    template <typename T> bool packArray(const std::vector<T> &, std::false_type) { return false; }
+    template <typename T> bool unpackArray(std::vector<T> &, std::false_type) const { return false; }
     ArrayElementType arrayElementType(void) const
     {
         if (_type != Type::TypeCode::Array)
@@ -237,6 +466,8 @@ private:
 public:
     size_t hash(void) const
     {
+        load();
+
         /* hash of the type */
         int type = static_cast<int>(_type);
         size_t hash = std::hash<int>()(type);
@@ -260,20 +491,20 @@ public:
             case Type::TypeCode::String  : return hashCombine(hash, std::hash<std::string>()(_string));
             case Type::TypeCode::Boolean : return hashCombine(hash, std::hash<bool       >()(_bool  ));
 
+            /* entries are summed up, so the hash doesn't depend on iteration order */
             case Type::TypeCode::Map:
             {
-                for (const auto &item : _map)
-                {
-                    hash = hashCombine(hash, item.second->hash());
-                    hash = hashCombine(hash, item.first.key->hash());
-                }
+                size_t sum = 0;
 
-                return hash;
+                for (const auto &item : compound().map)
+                    sum += hashCombine(item.first.key->hash(), item.second->hash());
+
+                return hashCombine(hash, sum);
             }
 
             case Type::TypeCode::Array:
             {
-                for (const auto &item : _array)
+                for (const auto &item : compound().array)
                     hash = hashCombine(hash, item->hash());
 
                 return hash;
@@ -281,13 +512,12 @@ public:
 
             case Type::TypeCode::Object:
             {
-                for (const auto &item : _object)
-                {
-                    hash = hashCombine(hash, item.second->hash());
-                    hash = hashCombine(hash, std::hash<std::string>()(item.first));
-                }
+                size_t sum = 0;
 
-                return hash;
+                for (const auto &item : compound().object)
+                    sum += hashCombine(std::hash<std::string>()(item.first), item.second->hash());
+
+                return hashCombine(hash, sum);
             }
         }
     }
@@ -296,6 +526,10 @@ public:
     bool operator!=(const Variant &other) const { return !(*this == other); }
     bool operator==(const Variant &other) const
     {
+        /* decode deferred values of both side */
+        load();
+        other.load();
+
         /* must be the same type */
         if (_type != other._type)
             return false;
@@ -321,17 +555,17 @@ public:
             case Type::TypeCode::Map:
             {
                 /* check the map size */
-                if (_map.size() != other._map.size())
+                if (compound().map.size() != other.compound().map.size())
                     return false;
 
                 /* compare each item */
-                for (const auto &item : _map)
+                for (const auto &item : compound().map)
                 {
                     /* locate in `other` map */
-                    auto iter = other._map.find(item.first);
+                    auto iter = other.compound().map.find(item.first);
 
                     /* check for existence */
-                    if (iter == other._map.end())
+                    if (iter == other.compound().map.end())
                         return false;
 
                     /* check for value */
@@ -346,11 +580,11 @@ public:
             case Type::TypeCode::Array:
             {
                 /* check the array size */
-                if (_array.size() != other._array.size())
+                if (compound().array.size() != other.compound().array.size())
                     return false;
 
                 /* compare each item */
-                for (auto x = _array.begin(), y = other._array.begin(); (x != _array.end()) && (y != other._array.end()); x++, y++)
+                for (auto x = compound().array.begin(), y = other.compound().array.begin(); (x != compound().array.end()) && (y != other.compound().array.end()); x++, y++)
                     if (**x != **y)
                         return false;
 
@@ -361,17 +595,17 @@ public:
             case Type::TypeCode::Object:
             {
                 /* check the object field count */
-                if (_object.size() != other._object.size())
+                if (compound().object.size() != other.compound().object.size())
                     return false;
 
                 /* compare each field */
-                for (const auto &item : _object)
+                for (const auto &item : compound().object)
                 {
                     /* locate in `other` object fields */
-                    auto iter = other._object.find(item.first);
+                    auto iter = other.compound().object.find(item.first);
 
                     /* check for existence */
-                    if (iter == other._object.end())
+                    if (iter == other.compound().object.end())
                         return false;
 
                     /* check for value */
@@ -639,7 +873,7 @@ private:
 
 public:
     template <typename T>
-    inline T get(std::enable_if_t<std::is_same<std::decay_t<T>, std::string>::value, TagString> = TagString())
+    inline T get(std::enable_if_t<std::is_same<std::decay_t<T>, std::string>::value, TagString> = TagString()) &
     {
         if (_type == Type::TypeCode::String)
             return _string;
@@ -649,7 +883,7 @@ public:
 
 public:
     template <typename T>
-    inline const std::string &get(std::enable_if_t<std::is_same<std::decay_t<T>, std::string>::value, TagString> = TagString()) const
+    inline const std::string &get(std::enable_if_t<std::is_same<std::decay_t<T>, std::string>::value, TagString> = TagString()) const &
     {
         if (_type == Type::TypeCode::String)
             return _string;
@@ -657,6 +891,16 @@ public:
             throw Exceptions::TypeError(toString() + " is not a `std::string`");
     }
 
+public:
+    template <typename T>
+    inline std::string get(std::enable_if_t<std::is_same<std::decay_t<T>, std::string>::value, TagString> = TagString()) &&
+    {
+        if (_type == Type::TypeCode::String)
+            return std::move(_string);
+        else
+            throw Exceptions::TypeError(toString() + " is not a `std::string`");
+    }
+
 /** Constant objects (maps, arrays and objects) **/
 
 private:
@@ -666,8 +910,10 @@ private:
 
 public:
     template <typename T>
-    inline T get(std::enable_if_t<Internal::IsMap<T>::value, TagCMap> = TagCMap()) const
+    inline T get(std::enable_if_t<Internal::IsMap<T>::value, TagCMap> = TagCMap()) const &
     {
+        load();
+
         if (_type != Type::TypeCode::Map)
             throw Exceptions::TypeError(toString() + " is not a map");
 
@@ -675,7 +921,7 @@ public:
         T map;
 
         /* fill each item */
-        for (const auto &item : _map)
+        for (const auto &item : compound().map)
         {
             map.emplace(
                 item.first.key->get<typename Internal::IsMap<T>::KeyType>(),
@@ -689,16 +935,22 @@ public:
 
 public:
     template <typename T>
-    inline T get(std::enable_if_t<Internal::IsVector<T>::value, TagCArray> = TagCArray()) const
+    inline T get(std::enable_if_t<Internal::IsVector<T>::value, TagCArray> = TagCArray()) const &
     {
-        if (_type != Type::TypeCode::Array)
-            throw Exceptions::TypeError(toString() + " is not an array");
-
         /* create result array */
         T array;
 
+        /* packed records are copied out without materializing */
+        if ((_type == Type::TypeCode::Array) && unpackArray(array, Internal::IsPackable<typename Internal::IsVector<T>::ItemType>()))
+            return std::move(array);
+
+        load();
+
+        if (_type != Type::TypeCode::Array)
+            throw Exceptions::TypeError(toString() + " is not an array");
+
         /* fill each item */
-        for (const auto &item : _array)
+        for (const auto &item : compound().array)
             array.push_back(item->get<typename Internal::IsVector<T>::ItemType>());
 
         /* move to prevent copy */
@@ -720,38 +972,37 @@ public:
         return std::move(object);
     }
 
-/** Wrapped objects (arrays and objects) **/
-
-private:
-    struct TagWMap {};
-    struct TagWType {};
-    struct TagWArray {};
-    struct TagWObject {};
+/** Expiring objects (maps and arrays) **/
 
 public:
     template <typename T>
-    inline T get(std::enable_if_t<Internal::IsTypeWrapper<T>::value, TagWType> = TagWType()) const
+    static T steal(const std::shared_ptr<Variant> &item)
     {
-        /* let the compiler decide which override should be used */
-        return T(getWrapped<typename T::Type>());
+        /* items are shared between copies of variants, only the sole owner can give them away */
+        if (item.use_count() == 1)
+            return std::move(*item).get<T>();
+        else
+            return static_cast<const Variant &>(*item).get<T>();
     }
 
-private:
+public:
     template <typename T>
-    inline std::shared_ptr<T> getWrapped(std::enable_if_t<Internal::IsMap<T>::value, TagWMap> = TagWMap()) const
+    inline T get(std::enable_if_t<Internal::IsMap<T>::value, TagCMap> = TagCMap()) &&
     {
+        load();
+
         if (_type != Type::TypeCode::Map)
             throw Exceptions::TypeError(toString() + " is not a map");
 
         /* create result map */
-        std::shared_ptr<T> map(new T);
+        T map;
 
-        /* fill each item */
-        for (const auto &item : _map)
+        /* keys are part of the hash map, so only values are moved out */
+        for (const auto &item : compound().map)
         {
-            map->emplace(
+            map.emplace(
                 item.first.key->get<typename Internal::IsMap<T>::KeyType>(),
-                item.second->get<typename Internal::IsMap<T>::ValueType>()
+                steal<typename Internal::IsMap<T>::ValueType>(item.second)
             );
         }
 
@@ -759,46 +1010,61 @@ private:
         return std::move(map);
     }
 
-private:
+public:
     template <typename T>
-    inline std::shared_ptr<T> getWrapped(std::enable_if_t<Internal::IsVector<T>::value, TagWArray> = TagWArray()) const
+    inline T get(std::enable_if_t<Internal::IsVector<T>::value, TagCArray> = TagCArray()) &&
     {
+        /* create result array */
+        T array;
+
+        /* packed records are copied out without materializing */
+        if ((_type == Type::TypeCode::Array) && unpackArray(array, Internal::IsPackable<typename Internal::IsVector<T>::ItemType>()))
+            return std::move(array);
+
+        load();
+
         if (_type != Type::TypeCode::Array)
             throw Exceptions::TypeError(toString() + " is not an array");
 
-        /* create result array */
-        std::shared_ptr<T> array(new T);
-
-        /* fill each item */
-        for (const auto &item : _array)
-            array->push_back(item->get<typename Internal::IsVector<T>::ItemType>());
+        /* move each item out */
+        array.reserve(compound().array.size());
+        for (const auto &item : compound().array)
+            array.push_back(steal<typename Internal::IsVector<T>::ItemType>(item));
 
         /* move to prevent copy */
         return std::move(array);
     }
 
+/** Wrapped objects (arrays and objects) **/
+
 private:
+    struct TagWType {};
+
+public:
     template <typename T>
-    inline std::shared_ptr<T> getWrapped(std::enable_if_t<std::is_convertible<T *, Serializable *>::value, TagWObject> = TagWObject()) const
+    inline T get(std::enable_if_t<Internal::IsTypeWrapper<T>::value, TagWType> = TagWType()) const &
     {
-        if (_type != Type::TypeCode::Object)
-            throw Exceptions::TypeError(toString() + " is not an object");
-
-        /* create result object */
-        std::shared_ptr<T> object(new T);
+        /* the wrapper takes over the value produced by the constant getters */
+        return T(get<typename T::Type>());
+    }
 
-        /* deserialize from self */
-        object->deserialize(*this);
-        return std::move(object);
+public:
+    template <typename T>
+    inline T get(std::enable_if_t<Internal::IsTypeWrapper<T>::value, TagWType> = TagWType()) &&
+    {
+        /* or by the expiring getters, if any */
+        return T(std::move(*this).get<typename T::Type>());
     }
 
 public:
     size_t size(void) const
     {
+        load();
+
         if (_type == Type::TypeCode::Map)
-            return _map.size();
+            return compound().map.size();
         else if (_type == Type::TypeCode::Array)
-            return _array.size();
+            return compound().array.size();
         else
             throw Exceptions::TypeError(toString() + " is not an array");
     }
@@ -806,36 +1072,40 @@ public:
 public:
     Variant &operator[](ssize_t index)
     {
+        load();
+
         if (_type != Type::TypeCode::Array)
             throw Exceptions::TypeError(toString() + " is not an array");
-        else if (index < 0 || static_cast<size_t>(index) >= _array.size())
+        else if (index < 0 || static_cast<size_t>(index) >= compound().array.size())
             throw Exceptions::IndexError(index);
         else
-            return *_array[index].get();
+            return *compound().array[index].get();
     }
 
 public:
     const Variant &operator[](ssize_t index) const
     {
+        load();
+
         if (_type != Type::TypeCode::Array)
             throw Exceptions::TypeError(toString() + " is not an array");
-        else if (index < 0 || static_cast<size_t>(index) >= _array.size())
+        else if (index < 0 || static_cast<size_t>(index) >= compound().array.size())
             throw Exceptions::IndexError(index);
         else
-            return *_array[index].get();
+            return *compound().array[index].get();
     }
 
 /** BEGIN :: these methods should only be used by serialization / deserialization backends unless you know what you are doing **/
 
 public:
-    Map &internalMap(void) { return _map; }
-    Array &internalArray(void) { return _array; }
-    Object &internalObject(void) { return _object; }
+    Map &internalMap(void) { load(); return compound().map; }
+    Array &internalArray(void) { load(); return compound().array; }
+    Object &internalObject(void) { load(); return compound().object; }
 
 public:
-    const Map &internalMap(void) const { return _map; }
-    const Array &internalArray(void) const { return _array; }
-    const Object &internalObject(void) const { return _object; }
+    const Map &internalMap(void) const { load(); return compound().map; }
+    const Array &internalArray(void) const { load(); return compound().array; }
+    const Object &internalObject(void) const { load(); return compound().object; }
 
 /** END **/
 
@@ -871,7 +1141,7 @@ public:
         ArrayBuilder<Args ...>::build(array, std::forward<Args>(args) ...);
 
         /* replace internal array */
-        result._array = std::move(array);
+        result.compound().array = std::move(array);
         return result;
     }
 
@@ -895,7 +1165,7 @@ public:
 
         /* fill each key-value pair */
         for (const auto &pair : list)
-            result._object.emplace(pair.name, pair.value);
+            result.compound().object.emplace(pair.name, pair.value);
 
         return result;
     }
@@ -903,6 +1173,8 @@ public:
 public:
     std::string toString(void) const
     {
+        load();
+
         switch (_type)
         {
             /* void type */
@@ -935,7 +1207,7 @@ public:
             {
                 std::string result;
 
-                for (const auto &item : _map)
+                for (const auto &item : compound().map)
                 {
                     if (!result.empty())
                         result += ", ";
@@ -953,7 +1225,7 @@ public:
             {
                 std::string result;
 
-                for (const auto &item : _array)
+                for (const auto &item : compound().array)
                 {
                     if (!result.empty())
                         result += ", ";
@@ -969,7 +1241,7 @@ public:
             {
                 std::string result;
 
-                for (const auto &item : _object)
+                for (const auto &item : compound().object)
                 {
                     if (!result.empty())
                         result += ", ";
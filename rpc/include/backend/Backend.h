@@ -56,20 +56,85 @@ struct AssemblerCheck<ByteSeq(T::*)(Variant &&) const>
 
 struct Backend final
 {
+    /* byte-level transformation that runs after `assemble` and before `parse` */
+    struct Stage
+    {
+        virtual ~Stage() {}
+        virtual std::string name(void) const = 0;
+
+    public:
+        virtual ByteSeq encode(ByteSeq &&data) const = 0;
+        virtual ByteSeq decode(ByteSeq &&data) const = 0;
+
+    };
+
+public:
     class BackendProxy
     {
-        std::function<Variant(ByteSeq &&)> _parser;
-        std::function<ByteSeq(Variant &&)> _assembler;
+        typedef Variant (*Parser)(const void *, ByteSeq &&);
+        typedef ByteSeq (*Assembler)(const void *, Variant &&);
+
+    private:
+        Parser _parser;
+        Assembler _assembler;
+        std::shared_ptr<const void> _backend;
+
+    private:
+        std::vector<std::shared_ptr<const Stage>> _stages;
+
+    private:
+        /* type-erased trampolines, one direct call instead of `std::function` dispatching */
+        template <typename T>
+        static Variant parseThunk(const void *backend, ByteSeq &&data)
+        {
+            return static_cast<const T *>(backend)->parse(std::move(data));
+        }
+
+    private:
+        template <typename T>
+        static ByteSeq assembleThunk(const void *backend, Variant &&data)
+        {
+            return static_cast<const T *>(backend)->assemble(std::move(data));
+        }
+
+    public:
+        template <typename T>
+        explicit BackendProxy(std::shared_ptr<T> backend) :
+            _parser(&parseThunk<T>), _assembler(&assembleThunk<T>), _backend(std::move(backend)) {}
 
     public:
-        explicit BackendProxy(
-            std::function<Variant(ByteSeq &&)> &&parser,
-            std::function<ByteSeq(Variant &&)> &&assembler) :
-                _parser(std::move(parser)), _assembler(std::move(assembler)) {}
+        const std::vector<std::shared_ptr<const Stage>> &stages(void) const { return _stages; }
+
+    public:
+        /* new proxy with `stage` appended, this proxy is left untouched since it may be shared */
+        std::shared_ptr<BackendProxy> pipe(std::shared_ptr<const Stage> stage) const
+        {
+            std::shared_ptr<BackendProxy> result = std::make_shared<BackendProxy>(*this);
+            result->_stages.push_back(std::move(stage));
+            return result;
+        }
 
     public:
-        Variant parse(ByteSeq &&data) const { return _parser(std::move(data)); }
-        ByteSeq assemble(Variant &&data) const { return _assembler(std::move(data)); }
+        Variant parse(ByteSeq &&data) const
+        {
+            /* stages are undone in reverse order */
+            for (auto iter = _stages.rbegin(); iter != _stages.rend(); iter++)
+                data = (*iter)->decode(std::move(data));
+
+            return _parser(_backend.get(), std::move(data));
+        }
+
+    public:
+        ByteSeq assemble(Variant &&data) const
+        {
+            ByteSeq result = _assembler(_backend.get(), std::move(data));
+
+            /* apply stages in order */
+            for (const auto &stage : _stages)
+                result = stage->encode(std::move(result));
+
+            return result;
+        }
 
     };
 
@@ -92,7 +157,7 @@ private:
 
 public:
     template <typename T>
-    static void addBackend(const std::string &name, std::shared_ptr<T> backend)
+    static void addBackend(const std::string &name, std::shared_ptr<T> backend, bool fallback = true)
     {
         /* check for method existence in `T` */
         static_assert(
@@ -106,18 +171,31 @@ public:
             throw Exceptions::BackendDuplicatedError(name);
 
         /* build backend proxy and add to registry */
-        auto iter = backendsMap().emplace(name, std::make_shared<BackendProxy>(
-            [=](ByteSeq &&data) { return backend->parse(std::move(data)); },
-            [=](Variant &&data) { return backend->assemble(std::move(data)); }
-        ));
+        auto iter = backendsMap().emplace(name, std::make_shared<BackendProxy>(std::move(backend)));
 
-        /* set as default backend if not specified */
-        if (defaultBackendPtr() == nullptr)
+        /* set as default backend if not specified, unless it never wants to be the default */
+        if (fallback && (defaultBackendPtr() == nullptr))
             defaultBackendPtr() = iter.first->second;
     }
 
 #pragma clang diagnostic pop
 
+public:
+    /* register a pre-built proxy, usually a pipeline made by `BackendProxy::pipe` */
+    static void addBackend(const std::string &name, std::shared_ptr<BackendProxy> backend, bool fallback = true)
+    {
+        /* check for backend existence */
+        if (backendsMap().find(name) != backendsMap().end())
+            throw Exceptions::BackendDuplicatedError(name);
+
+        /* add to registry */
+        auto iter = backendsMap().emplace(name, std::move(backend));
+
+        /* set as default backend if not specified, unless it never wants to be the default */
+        if (fallback && (defaultBackendPtr() == nullptr))
+            defaultBackendPtr() = iter.first->second;
+    }
+
 public:
     static const std::shared_ptr<BackendProxy> &findBackend(const std::string &name)
     {
@@ -156,7 +234,30 @@ public:
     static ByteSeq assemble(Variant &&object) { return defaultBackend()->assemble(std::move(object)); }
 
 public:
+    /* compile-time binding, calls are resolved statically and can be inlined, bypassing the registry */
     template <typename T>
+    struct Static
+    {
+        static T instance;
+
+    public:
+        static Variant parse(ByteSeq &&data) { return instance.parse(std::move(data)); }
+        static ByteSeq assemble(Variant &&object) { return instance.assemble(std::move(object)); }
+
+    };
+
+public:
+    /* same interface as `Static<T>`, but selects the backend at runtime */
+    struct Dynamic
+    {
+        static Variant parse(ByteSeq &&data) { return Backend::parse(std::move(data)); }
+        static ByteSeq assemble(Variant &&object) { return Backend::assemble(std::move(object)); }
+
+    };
+
+public:
+    /* `Fallback` backends become the default if none specified, others must be selected explicitly */
+    template <typename T, bool Fallback = true>
     struct Register
     {
         static_assert(
@@ -167,12 +268,16 @@ public:
         Register()
         {
             std::shared_ptr<T> backend = std::make_shared<T>();
-            Backend::addBackend(backend->name(), backend);
+            Backend::addBackend(backend->name(), backend, Fallback);
         }
     };
 };
+
+template <typename T>
+T Backend::Static<T>::instance;
 }
 
 #define defineBackend(type) static ::SimpleRPC::Backend::Register<type> __SimpleRPC_Backend_ ## type ## _DO_NOT_TOUCH_THIS_VARIABLE__;
+#define defineAltBackend(type) static ::SimpleRPC::Backend::Register<type, false> __SimpleRPC_Backend_ ## type ## _DO_NOT_TOUCH_THIS_VARIABLE__;
 
 #endif /* SIMPLERPC_BACKEND_H */
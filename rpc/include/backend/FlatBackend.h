@@ -0,0 +1,205 @@
+/** Flat Serializer / Deserializer Backend
+ *  values carry offset tables, so any item can be read directly from the encoded bytes without parsing
+ *
+ *  every value starts with it's `Type::TypeCode` as one byte, all numbers are little-endian
+ *
+ *      scalars     : code, value
+ *      string      : code, u32 length, bytes
+ *      array       : code, u32 count, u32 offset[count], items
+ *      map         : code, u32 count, u32 offset[count * 2] (key, value pairs), items
+ *      object      : code, u32 count, u32 offset[count * 2] (name, value pairs, sorted by name), items
+ *
+ *  offsets are relative to the start of the container, and strictly increasing past the offset table
+ *  each item ends where the next one starts, the last one ends where the container ends
+ **/
+
+#ifndef SIMPLERPC_FLATBACKEND_H
+#define SIMPLERPC_FLATBACKEND_H
+
+#include <string>
+#include <type_traits>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "SimpleRPC.h"
+#include "backend/Backend.h"
+
+namespace SimpleRPC
+{
+namespace Backends
+{
+struct FlatBackend
+{
+    std::string name(void) const { return "Backends.Flat"; }
+
+public:
+    Variant parse(ByteSeq &&data) const;
+    ByteSeq assemble(Variant &&object) const;
+
+public:
+    /* read-only view of an encoded value, opening a view doesn't decode anything */
+    class View
+    {
+        const uint8_t *_p;
+        const uint8_t *_end;
+
+    private:
+        struct TagScalar {};
+        struct TagString {};
+        struct TagGeneric {};
+
+    public:
+        /* view refers to the buffer directly, so it must outlive the view */
+        explicit View(ByteSeq &&data) = delete;
+        explicit View(const ByteSeq &data) : View(data.data(), data.length()) {}
+        explicit View(const void *data, size_t size);
+
+    public:
+        Type::TypeCode type(void) const { return static_cast<Type::TypeCode>(*_p); }
+
+    public:
+        /* length of strings, or item count of containers */
+        size_t size(void) const;
+
+    public:
+        /* array items */
+        View operator[](size_t index) const;
+
+    public:
+        /* map entries */
+        View key(size_t index) const;
+        View value(size_t index) const;
+
+    public:
+        /* object fields, lookup by name is a binary search */
+        bool hasField(const std::string &name) const;
+        View field(const std::string &name) const;
+
+    public:
+        template <typename T>
+        T get(void) const
+        {
+            /* let the compiler decide which override should be used */
+            return get<T>(std::conditional_t<
+                std::is_arithmetic<T>::value,
+                TagScalar,
+                std::conditional_t<std::is_same<T, std::string>::value, TagString, TagGeneric>
+            >());
+        }
+
+    public:
+        /* decode the whole value */
+        Variant toVariant(void) const { return toVariant(0); }
+
+    private:
+        template <typename T>
+        static constexpr Type::TypeCode scalarType(void)
+        {
+            return std::is_same<T, bool  >::value ? Type::TypeCode::Boolean :
+                   std::is_same<T, float >::value ? Type::TypeCode::Float   :
+                   std::is_same<T, double>::value ? Type::TypeCode::Double  :
+                   std::is_signed<T>::value ? (
+                       sizeof(T) == sizeof(int8_t ) ? Type::TypeCode::Int8  :
+                       sizeof(T) == sizeof(int16_t) ? Type::TypeCode::Int16 :
+                       sizeof(T) == sizeof(int32_t) ? Type::TypeCode::Int32 : Type::TypeCode::Int64
+                   ) : (
+                       sizeof(T) == sizeof(uint8_t ) ? Type::TypeCode::UInt8  :
+                       sizeof(T) == sizeof(uint16_t) ? Type::TypeCode::UInt16 :
+                       sizeof(T) == sizeof(uint32_t) ? Type::TypeCode::UInt32 : Type::TypeCode::UInt64
+                   );
+        }
+
+    private:
+        template <typename T>
+        T get(TagScalar) const
+        {
+            /* must be exactly the same type */
+            if (type() != scalarType<T>())
+                throw Exceptions::TypeError("Value is not a " + Internal::TypeItem<T>::type().toSignature());
+
+            /* scalar sizes are checked when opening the view */
+            T result;
+            memcpy(&result, _p + 1, sizeof(T));
+            return result;
+        }
+
+    private:
+        template <typename T>
+        T get(TagString) const
+        {
+            if (type() != Type::TypeCode::String)
+                throw Exceptions::TypeError("Value is not a string");
+            else
+                return std::string(reinterpret_cast<const char *>(_p) + 5, size());
+        }
+
+    private:
+        template <typename T>
+        T get(TagGeneric) const
+        {
+            /* compound types are decoded through `Variant` */
+            return toVariant().get<T>();
+        }
+
+    private:
+        View item(size_t index) const;
+        size_t offsetOf(size_t index) const;
+        bool locate(const std::string &name, size_t &index) const;
+
+    private:
+        Variant toVariant(size_t depth) const;
+
+    };
+};
+
+template <typename T>
+class FlatObjectView
+{
+    FlatBackend::View _view;
+    Registry::MetaClass _meta;
+
+public:
+    explicit FlatObjectView(ByteSeq &&data) = delete;
+    explicit FlatObjectView(const ByteSeq &data) : _view(data), _meta(metaClassOf<T>())
+    {
+        if (_view.type() != Type::TypeCode::Object)
+            throw Exceptions::TypeError("Value is not an object");
+    }
+
+public:
+    const FlatBackend::View &view(void) const { return _view; }
+
+public:
+    template <typename U>
+    U get(const std::string &name) const
+    {
+        /* find field by name */
+        const auto &fields = _meta.fields();
+        const auto &iter = fields.find(name);
+
+        /* not found, it's an error */
+        if (iter == fields.end())
+            throw Exceptions::ReflectionError("No such field \"" + name + "\"");
+
+        /* field type must match the declaration */
+        if (iter->second->type().typeCode() != Internal::TypeItem<U>::type().typeCode())
+            throw Exceptions::TypeError("Field \"" + name + "\" is declared as " + iter->second->type().toSignature());
+
+        /* read directly from the encoded bytes */
+        return _view.field(name).template get<U>();
+    }
+
+public:
+    T load(void) const
+    {
+        /* decode the whole object */
+        T object;
+        object.deserialize(_view.toVariant());
+        return object;
+    }
+};
+}
+}
+
+#endif /* SIMPLERPC_FLATBACKEND_H */
@@ -0,0 +1,45 @@
+/** JSON Serializer / Deserializer Backend
+ *  for ``JSON Specification'' please refer to [https://tools.ietf.org/html/rfc8259]
+ *
+ *  types that JSON can't tell apart are annotated with single-key objects, so the mapping is lossless
+ *
+ *      void        : null
+ *      boolean     : true / false
+ *      int32_t     : 123
+ *      double      : 1.0, 1.5e+300 (always has a decimal point or an exponent)
+ *      string      : "text"
+ *      array       : [item, ...]
+ *      object      : {"field": value, ...}
+ *      other ints  : {"$i8": -1}, {"$i16": ...}, {"$i64": ...}, {"$u8": 1}, ..., {"$u64": ...}
+ *      float       : {"$f32": 1.5}
+ *      map         : {"$map": [[key, value], ...]}
+ *      NaN / inf   : {"$f64": "NaN"}, {"$f32": "-Infinity"}
+ *
+ *  field names of objects are C++ identifiers, so they never collide with annotations
+ *  other keys starting with `$`, such as "$ref", are read as ordinary object fields
+ **/
+
+#ifndef SIMPLERPC_JSONBACKEND_H
+#define SIMPLERPC_JSONBACKEND_H
+
+#include <string>
+#include "SimpleRPC.h"
+#include "backend/Backend.h"
+
+namespace SimpleRPC
+{
+namespace Backends
+{
+struct JSONBackend
+{
+    std::string name(void) const { return "Backends.JSON"; }
+
+public:
+    Variant parse(ByteSeq &&data) const;
+    ByteSeq assemble(Variant &&object) const;
+
+};
+}
+}
+
+#endif /* SIMPLERPC_JSONBACKEND_H */
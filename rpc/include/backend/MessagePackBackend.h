@@ -6,6 +6,9 @@
 #define SIMPLERPC_MESSAGEPACKBACKEND_H
 
 #include <string>
+#include <vector>
+#include <unordered_map>
+
 #include "SimpleRPC.h"
 #include "backend/Backend.h"
 
@@ -17,14 +20,248 @@ struct MessagePackBackend
 {
     std::string name(void) const { return "Backends.MessagePack"; }
 
+public:
+    /* connection-scoped table of object field names, one for each direction of a connection
+     * the first occurrence of a name is sent as a string and registered on both sides,
+     * later occurrences are sent as it's index in place of the string
+     * both sides must process messages in the same order, and drop the table if any error occurs */
+    class KeyDictionary
+    {
+        KeyDictionary(const KeyDictionary &) = delete;
+        KeyDictionary &operator=(const KeyDictionary &) = delete;
+
+    private:
+        size_t _capacity;
+        std::vector<std::string> _keys;
+        std::unordered_map<std::string, uint32_t> _ids;
+
+    public:
+        explicit KeyDictionary(size_t capacity = 4096) : _capacity(capacity) {}
+
+    public:
+        size_t size(void) const { return _keys.size(); }
+        size_t capacity(void) const { return _capacity; }
+
+    public:
+        void clear(void);
+        void add(const std::string &key);
+
+    public:
+        bool find(const std::string &key, uint32_t &id) const;
+        const std::string &key(const Variant &ref) const;
+
+    };
+
+private:
+    /* container that is being filled by the decoder, values are created where their parents keep them */
+    struct Frame
+    {
+        std::shared_ptr<Variant> key;
+        std::shared_ptr<Variant> value;
+        size_t remains;
+
+    public:
+        explicit Frame(Type::TypeCode type, size_t remains) : value(std::make_shared<Variant>(type)), remains(remains) {}
+
+    };
+
+private:
+    static bool attach(std::vector<Frame> &stack, std::shared_ptr<Variant> &value, KeyDictionary *keys = nullptr);
+
 private:
-    Variant doParse(ByteSeq &seq) const;
-    ByteSeq doAssemble(Variant &object) const;
+    static Variant decode(const uint8_t *&p, const uint8_t *end, KeyDictionary *keys = nullptr);
+    static const uint8_t *skip(const uint8_t *p, const uint8_t *end, size_t count);
+
+private:
+    Variant doParse(ByteSeq &seq, KeyDictionary *keys) const;
+    ByteSeq doAssemble(Variant &object, KeyDictionary *keys, bool canonical = false) const;
+
+public:
+    Variant parse(ByteSeq &&data) const { return doParse(data, nullptr); }
+    ByteSeq assemble(Variant &&object) const { return doAssemble(object, nullptr); }
+
+public:
+    Variant parseKeyed(ByteSeq &&data, KeyDictionary &keys) const { return doParse(data, &keys); }
+    ByteSeq assembleKeyed(Variant &&object, KeyDictionary &keys) const { return doAssemble(object, &keys); }
 
 public:
-    Variant parse(ByteSeq &&data) const { return doParse(data); }
-    ByteSeq assemble(Variant &&object) const { return doAssemble(object); }
+    /* deterministic encoding, equal values always produce identical bytes
+     * map keys and object fields are sorted, lengths use the shortest headers, and NaNs and zeros are normalized
+     * integers keep the width of their types, which is already unique, so values decode to the same types */
+    ByteSeq assembleCanonical(Variant &&object) const { return doAssemble(object, nullptr, true); }
+
+private:
+    struct Loader;
+
+public:
+    /* compound values are decoded on first access, the buffer is kept alive by them */
+    Variant parseLazy(ByteSeq &&data) const;
+
+public:
+    /* resumable parser, can be fed with partial data as it arrives from the network */
+    class Parser
+    {
+        Parser(const Parser &) = delete;
+        Parser &operator=(const Parser &) = delete;
+
+    private:
+        bool _done;
+        size_t _maxDepth;
+
+    private:
+        ByteSeq _buffer;
+        Variant _result;
+        std::vector<Frame> _stack;
+
+    public:
+        explicit Parser(size_t maxDepth = 64) : _done(false), _maxDepth(maxDepth) {}
+
+    public:
+        bool isDone(void) const { return _done; }
+        size_t pending(void) const { return _buffer.length(); }
 
+    public:
+        bool feed(const ByteSeq &data) { return feed(data.data(), data.length()); }
+        bool feed(const void *data, size_t size);
+
+    public:
+        void reset(void);
+        Variant result(void);
+
+    private:
+        bool step(void);
+        void complete(Variant &&value);
+
+    };
+
+public:
+    /* pull-style event reader, values are decoded in place without building `Variant` trees */
+    class Reader
+    {
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+    public:
+        enum class Event
+        {
+            Nil,
+            Boolean,
+            Integer,
+            UnsignedInteger,
+            Real,
+            String,
+            Key,
+            BeginMap,
+            BeginArray,
+            BeginObject,
+            End,
+            Finish,
+        };
+
+    private:
+        struct Level
+        {
+            size_t remains;
+            Type::TypeCode type;
+
+        public:
+            explicit Level(Type::TypeCode type, size_t remains) : remains(remains), type(type) {}
+
+        };
+
+    private:
+        const uint8_t *_p;
+        const uint8_t *_end;
+        const uint8_t *_begin;
+
+    private:
+        bool _started;
+        Event _event;
+        std::vector<Level> _stack;
+
+    private:
+        union
+        {
+            bool     _bool;
+            double   _real;
+            int64_t  _integer;
+            uint64_t _unsigned;
+        };
+
+    private:
+        size_t _length;
+        const char *_string;
+        Type::TypeCode _type;
+
+    public:
+        /* reader refers to the buffer directly, so it must outlive the reader */
+        explicit Reader(ByteSeq &&data) = delete;
+        explicit Reader(const ByteSeq &data) : Reader(data.data(), data.length()) {}
+        explicit Reader(const void *data, size_t size) :
+            _p(reinterpret_cast<const uint8_t *>(data)),
+            _end(reinterpret_cast<const uint8_t *>(data) + size),
+            _begin(reinterpret_cast<const uint8_t *>(data)),
+            _started(false),
+            _event(Event::Finish),
+            _unsigned(0),
+            _length(0),
+            _string(nullptr),
+            _type(Type::TypeCode::Void) {}
+
+    public:
+        Event event(void) const { return _event; }
+        size_t depth(void) const { return _stack.size(); }
+        size_t offset(void) const { return static_cast<size_t>(_p - _begin); }
+
+    public:
+        /* precise type of current scalar value, or type of the container that just began */
+        Type::TypeCode type(void) const { return _type; }
+
+    public:
+        bool boolean(void) const { return _bool; }
+        double real(void) const { return _real; }
+        int64_t integer(void) const { return _integer; }
+        uint64_t unsignedInteger(void) const { return _unsigned; }
+
+    public:
+        /* string (or key) content, or item count of the container that just began */
+        size_t length(void) const { return _length; }
+        const char *data(void) const { return _string; }
+        std::string string(void) const { return std::string(_string, _length); }
+
+    public:
+        Event next(void);
+        Variant read(void);
+
+    public:
+        /* skip the rest of the container that just began, including it's `End` event */
+        void skip(void);
+
+    public:
+        /* fill fields of an object directly by it's field offsets */
+        void readObject(Serializable &object);
+
+    private:
+        bool advance(void);
+        void readField(Field &field, Serializable &object);
+
+    private:
+        /* current scalar as a value, for checking types the same way as `Variant::get` */
+        Variant scalar(void) const;
+
+    };
+};
+
+struct LazyMessagePackBackend : public MessagePackBackend
+{
+    std::string name(void) const { return "Backends.MessagePack.Lazy"; }
+    Variant parse(ByteSeq &&data) const { return parseLazy(std::move(data)); }
+};
+
+struct CanonicalMessagePackBackend : public MessagePackBackend
+{
+    std::string name(void) const { return "Backends.MessagePack.Canonical"; }
+    ByteSeq assemble(Variant &&object) const { return assembleCanonical(std::move(object)); }
 };
 }
 }
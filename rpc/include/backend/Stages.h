@@ -0,0 +1,67 @@
+/** Byte-level pipeline stages for backends
+ *  stages are attached with `BackendProxy::pipe`, for example
+ *
+ *      Backend::addBackend("Backends.MessagePack.LZ4", Backend::findBackend("Backends.MessagePack")
+ *          ->pipe(std::make_shared<Backends::CompressionStage>())
+ *          ->pipe(std::make_shared<Backends::ChecksumStage>()));
+ *
+ *  compression   : payload, [u32 raw length], u8 method (0 = stored, 1 = LZ4 block)
+ *  checksum      : payload, u32 CRC32C of payload
+ *
+ *  both are trailers so stored payloads are passed through without copying, all numbers are little-endian
+ **/
+
+#ifndef SIMPLERPC_STAGES_H
+#define SIMPLERPC_STAGES_H
+
+#include <string>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "backend/Backend.h"
+
+namespace SimpleRPC
+{
+namespace Backends
+{
+struct CompressionStage : public Backend::Stage
+{
+    size_t _threshold;
+
+public:
+    /* payloads shorter than `threshold` bytes are stored as is */
+    explicit CompressionStage(size_t threshold = 512) : _threshold(threshold) {}
+
+public:
+    virtual std::string name(void) const override { return "Stages.LZ4"; }
+
+public:
+    virtual ByteSeq encode(ByteSeq &&data) const override;
+    virtual ByteSeq decode(ByteSeq &&data) const override;
+
+public:
+    /* raw LZ4 block format, without any headers */
+    static size_t compressBound(size_t size) { return size + size / 255 + 16; }
+    static size_t compress(const void *src, size_t size, void *dest);
+    static void decompress(const void *src, size_t size, void *dest, size_t length);
+
+};
+
+struct ChecksumStage : public Backend::Stage
+{
+    virtual std::string name(void) const override { return "Stages.CRC32C"; }
+
+public:
+    virtual ByteSeq encode(ByteSeq &&data) const override;
+    virtual ByteSeq decode(ByteSeq &&data) const override;
+
+public:
+    /* uses SSE4.2 `crc32` instructions when the CPU supports them */
+    static uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0);
+
+};
+}
+}
+
+#endif /* SIMPLERPC_STAGES_H */
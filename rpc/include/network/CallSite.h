@@ -4,6 +4,8 @@
 #define SIMPLERPC_CALLSITE_H
 
 #include <string>
+#include <vector>
+
 #include "Variant.h"
 #include "TypeInfo.h"
 #include "Exceptions.h"
@@ -26,8 +28,8 @@ struct CompositeUnwrapper<T, true>
 {
     static T unwrap(Variant &&value)
     {
-        /* composite value, unwrap from type wrapper */
-        return std::move(*value.get<Internal::TypeWrapper<T>>());
+        /* composite value, moved out of the expiring result */
+        return std::move(value).get<T>();
     }
 };
 
@@ -36,8 +38,8 @@ struct CompositeUnwrapper<T, false>
 {
     static T unwrap(Variant &&value)
     {
-        /* simple value, use standard getter */
-        return std::move(value.get<T>());
+        /* simple value, strings are moved out too */
+        return std::move(value).get<T>();
     }
 };
 
@@ -155,12 +157,43 @@ public:
     virtual void cleanup(size_t id) noexcept = 0;
     virtual size_t startup(const std::string &name) = 0;
 
+public:
+    /* bulk versions of `startup` and `cleanup`, sites should override them to do the work in a single exchange */
+    virtual void cleanupMany(const std::vector<size_t> &ids) noexcept
+    {
+        for (size_t id : ids)
+            cleanup(id);
+    }
+
+    virtual std::vector<size_t> startupMany(const std::string &name, size_t count)
+    {
+        std::vector<size_t> ids;
+        ids.reserve(count);
+
+        try
+        {
+            /* start them one by one */
+            for (size_t i = 0; i < count; i++)
+                ids.push_back(startup(name));
+        }
+        catch (...)
+        {
+            /* don't leave half of them behind */
+            cleanupMany(ids);
+            throw;
+        }
+
+        return ids;
+    }
+
 public:
     virtual Variant invoke(size_t id, const std::string &name, const std::string &signature, Variant &args) = 0;
     virtual Variant invoke(size_t id, const std::string &name, const std::string &signature, Variant &&args) { return invoke(id, name, signature, args); }
 
 public:
-    template <typename R, typename ... Args>
+    /* `Patch` tells whether the method takes mutable references, by it's declared signature, types deduced
+     * here can't tell since every lvalue argument is deduced as a mutable reference, so it patches by default */
+    template <typename R, bool Patch = true, typename ... Args>
     R invoke(size_t id, const std::string &name, const std::string &signature, Args && ... args)
     {
         /* construct argument pack, and delegate to real call site */
@@ -168,7 +201,8 @@ public:
         Variant result = invoke(id, name, signature, argv);
 
         /* patch values back from variants, this is required to support mutable reference */
-        Helpers::BackPatcher<Args ...>::patch(std::move(argv), std::forward<Args>(args) ...);
+        if (Patch)
+            Helpers::BackPatcher<Args ...>::patch(std::move(argv), std::forward<Args>(args) ...);
 
         /* unwrap result from variant */
         return Helpers::Unwrapper<R>::unwrap(std::move(result));
@@ -4,6 +4,8 @@
 #define SIMPLERPC_INVOKEPROXY_H
 
 #include <string>
+#include <memory>
+#include <vector>
 #include <stdexcept>
 
 #include "CallSite.h"
@@ -23,6 +25,10 @@ public:
     virtual ~InvokeProxy() { setSite(nullptr); }
     explicit InvokeProxy(CallSite *site, const std::string &name) : _id(0), _site(nullptr), _class(name) { setSite(site); }
 
+public:
+    /* adopts an ID that is already started on the site */
+    explicit InvokeProxy(CallSite *site, const std::string &name, size_t id) : _id(id), _site(site), _class(name) {}
+
 public:
     size_t id(void) const { return _id; }
     CallSite *site(void) const { return _site; }
@@ -40,8 +46,17 @@ public:
     }
 
 public:
-    template <typename R, typename ... Args>
-    R invoke(const char *name, Args && ... args) const
+    /* detach from the site without cleaning up, the ID is returned and the caller takes over it */
+    size_t detach(void)
+    {
+        _site = nullptr;
+        return _id;
+    }
+
+public:
+    /* the method pointer only carries the declared signature of the method */
+    template <typename T, typename R, typename ... Declared, typename ... Args>
+    R invoke(R (T::*)(Declared ...), const char *name, Args && ... args) const
     {
         /* check for call-site */
         if (_site == nullptr)
@@ -54,8 +69,8 @@ public:
          * types, the `thread_local` specifier is to prevent locks being used */
         static thread_local Internal::MetaMethod<R, Args ...> method;
 
-        /* invoke actual method through call-site */
-        return _site->invoke<R>(_id, name, method.signature, std::forward<Args>(args) ...);
+        /* invoke actual method through call-site, values are patched back only for mutable reference parameters */
+        return _site->invoke<R, Internal::HasMutableReference<Declared ...>::value>(_id, name, method.signature, std::forward<Args>(args) ...);
     }
 };
 
@@ -64,6 +79,70 @@ struct InvokeProxyAdapter : public InvokeProxy
 {
     explicit InvokeProxyAdapter(CallSite *site) :
         InvokeProxy(site, Internal::TypeItem<T>::type().toSignature()) {}
+
+    explicit InvokeProxyAdapter(CallSite *site, size_t id) :
+        InvokeProxy(site, Internal::TypeItem<T>::type().toSignature(), id) {}
+};
+
+/* proxies of many objects of the same class, started and cleaned up with a single exchange */
+template <typename T>
+class ProxyArray
+{
+    typedef typename T::Proxy Proxy;
+
+private:
+    CallSite *_site;
+    std::vector<std::unique_ptr<Proxy>> _proxies;
+
+private:
+    ProxyArray(const ProxyArray &) = delete;
+    ProxyArray &operator=(const ProxyArray &) = delete;
+
+public:
+    explicit ProxyArray(CallSite *site, size_t count) : _site(site)
+    {
+        std::vector<size_t> ids = _site->startupMany(Internal::TypeItem<T>::type().toSignature(), count);
+
+        try
+        {
+            /* proxies adopt the started IDs */
+            _proxies.reserve(ids.size());
+            for (size_t id : ids)
+                _proxies.emplace_back(new Proxy(_site, id));
+        }
+        catch (...)
+        {
+            /* IDs are all cleaned up below */
+            for (const auto &proxy : _proxies)
+                proxy->detach();
+
+            _site->cleanupMany(ids);
+            throw;
+        }
+    }
+
+public:
+    ~ProxyArray()
+    {
+        std::vector<size_t> ids;
+        ids.reserve(_proxies.size());
+
+        /* detach every proxy to prevent cleaning them up one by one, moved ones clean up themselves */
+        for (const auto &proxy : _proxies)
+            if (proxy->site() == _site)
+                ids.push_back(proxy->detach());
+
+        _site->cleanupMany(ids);
+    }
+
+public:
+    size_t size(void) const { return _proxies.size(); }
+    CallSite *site(void) const { return _site; }
+
+public:
+    Proxy &operator[](size_t index) { return *_proxies[index]; }
+    const Proxy &operator[](size_t index) const { return *_proxies[index]; }
+
 };
 }
 }
@@ -5,6 +5,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <unordered_map>
 
 #include "SimpleRPC.h"
@@ -15,13 +16,38 @@ namespace Network
 {
 class LocalCallSite : public CallSite
 {
+public:
+    /* brings a recycled object back to a fresh state before it's handed out again */
+    typedef void (* Reset)(Serializable *object);
+
+private:
+    struct Pool
+    {
+        Reset reset = nullptr;
+        size_t limit = 0;
+        std::vector<std::unique_ptr<Serializable>> objects;
+    };
+
+private:
     size_t _id = 0;
     std::unordered_map<size_t, std::unique_ptr<Serializable>> _objects;
+    std::unordered_map<Registry::MetaPtr, Pool> _pools;
+
+public:
+    /* keeps at most `limit` released objects of the class for later `startup`, 0 disables pooling
+     * recycled objects keep whatever state they had, unless `reset` is given */
+    void setPoolSize(const std::string &name, size_t limit, Reset reset = nullptr);
 
 public:
     virtual void cleanup(size_t id) noexcept override;
     virtual size_t startup(const std::string &name) override;
 
+private:
+    size_t instantiate(Registry::MetaClass meta);
+
+public:
+    virtual std::vector<size_t> startupMany(const std::string &name, size_t count) override;
+
 public:
     virtual Variant invoke(size_t id, const std::string &name, const std::string &signature, Variant &args) override;
 
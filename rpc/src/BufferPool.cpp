@@ -0,0 +1,654 @@
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "BufferPool.h"
+#include "Exceptions.h"
+
+namespace SimpleRPC
+{
+enum class BlockSource : uint16_t
+{
+    Heap,
+    Slab,
+    Oversized,
+    Mapped,
+    MappedFile,
+};
+
+/* hidden header in front of every block, keeps the block 16-byte aligned */
+struct alignas(16) BlockHeader
+{
+    std::atomic<uint32_t> refs;
+    uint16_t sizeClass;
+    BlockSource source;
+    size_t capacity;
+
+public:
+    explicit BlockHeader(BlockSource source, size_t sizeClass, size_t capacity) :
+        refs(1), sizeClass(static_cast<uint16_t>(sizeClass)), source(source), capacity(capacity) {}
+
+};
+
+static_assert(sizeof(BlockHeader) == 16, "Block header must be exactly 16 bytes");
+
+/* cached blocks are linked through their own memory */
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+/* at most 128 KiB of blocks are cached by each thread for each class, but at least 2 blocks */
+static const size_t CacheBytes = 128 * 1024;
+static const size_t CacheBlocks = 2;
+
+/* slabs are rounded up to huge page size */
+static const size_t HugePageSize = 2 * 1024 * 1024;
+
+/* blocks not less than this are mapped from the system */
+static std::atomic<size_t> mapThreshold {64 * 1024 * 1024};
+
+static inline BlockHeader *headerOf(const void *mem)
+{
+    return reinterpret_cast<BlockHeader *>(reinterpret_cast<uintptr_t>(mem) - sizeof(BlockHeader));
+}
+
+static inline size_t classOf(size_t size)
+{
+    /* smallest power of two that not less than `size` */
+    if (size <= (1ul << BufferPool::MinClassShift))
+        return 0;
+    else
+        return 64 - __builtin_clzll(size - 1) - BufferPool::MinClassShift;
+}
+
+static inline size_t classSize(size_t sizeClass)
+{
+    return 1ul << (sizeClass + BufferPool::MinClassShift);
+}
+
+static inline size_t pageSize(void)
+{
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+static inline size_t roundPages(size_t size)
+{
+    return (size + pageSize() - 1) / pageSize() * pageSize();
+}
+
+/****** Huge-page slab ******/
+
+struct Slab
+{
+    size_t size = 0;
+    std::atomic<char *> mem {nullptr};
+    std::atomic<size_t> used {0};
+
+public:
+    std::mutex lock;
+    FreeBlock *blocks[BufferPool::ClassCount] = {};
+
+};
+
+static Slab &slab(void)
+{
+    /* use function wrapper to get rid of the initialization order problem */
+    static Slab instance;
+    return instance;
+}
+
+static void freeBlock(BlockHeader *header)
+{
+    /* slab blocks are never returned to the system */
+    if (header->source != BlockSource::Slab)
+    {
+        free(header);
+        return;
+    }
+
+    /* shared by all threads */
+    Slab &s = slab();
+    FreeBlock *block = reinterpret_cast<FreeBlock *>(header + 1);
+    std::lock_guard<std::mutex> _(s.lock);
+
+    /* add to slab free list */
+    block->next = s.blocks[header->sizeClass];
+    s.blocks[header->sizeClass] = block;
+}
+
+/****** Memory-mapped blocks ******/
+
+/** mapped blocks have a whole page in front of them, which holds the mapping info and the block header
+ *
+ *      | MappedInfo ... BlockHeader | payload ... |
+ *      ^ base                       ^ base + page size
+ **/
+struct MappedInfo
+{
+    int fd;         /* backing file for `sendfile`, -1 if none */
+    off_t offset;   /* offset of the payload in the file */
+    size_t size;    /* size of the whole mapping */
+};
+
+static inline MappedInfo *infoOf(BlockHeader *header)
+{
+    return reinterpret_cast<MappedInfo *>(reinterpret_cast<char *>(header + 1) - pageSize());
+}
+
+static BlockHeader *initMapped(char *base, BlockSource source, int fd, off_t offset, size_t size, size_t capacity)
+{
+    MappedInfo *info = reinterpret_cast<MappedInfo *>(base);
+
+    /* mapping info at the start of the first page */
+    info->fd = fd;
+    info->size = size;
+    info->offset = offset;
+
+    /* block header at the end of the first page */
+    return new (base + pageSize() - sizeof(BlockHeader)) BlockHeader(source, 0, capacity);
+}
+
+static void unmapBlock(BlockHeader *header)
+{
+    MappedInfo *info = infoOf(header);
+
+    /* mapping info is gone after unmapping */
+    int fd = info->fd;
+    munmap(info, info->size);
+
+    /* close the backing file if any */
+    if (fd >= 0)
+        close(fd);
+}
+
+static void *mapAnonymous(size_t size, size_t &capacity)
+{
+    int fd = -1;
+    size_t bytes = pageSize() + roundPages(size);
+
+#if defined(MFD_CLOEXEC)
+    /* backed by an in-memory file, so it can be sent by `sendfile`, and grown by `ftruncate` and `mremap` */
+    if (((fd = memfd_create("SimpleRPC.BufferPool", MFD_CLOEXEC)) >= 0) && ftruncate(fd, static_cast<off_t>(bytes)))
+    {
+        close(fd);
+        fd = -1;
+    }
+#endif
+
+    /* map the whole block */
+    void *base = (fd >= 0)
+        ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        : mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    /* out of memory */
+    if (base == MAP_FAILED)
+    {
+        if (fd >= 0)
+            close(fd);
+
+        throw std::bad_alloc();
+    }
+
+    /* payload starts at the second page */
+    capacity = bytes - pageSize();
+    return initMapped(reinterpret_cast<char *>(base), BlockSource::Mapped, fd, static_cast<off_t>(pageSize()), bytes, capacity) + 1;
+}
+
+static void *remapAnonymous(BlockHeader *header, size_t size, size_t &capacity)
+{
+#if defined(MREMAP_MAYMOVE)
+    MappedInfo *info = infoOf(header);
+    size_t bytes = pageSize() + roundPages(size);
+
+    /* grow the backing file first */
+    if ((info->fd >= 0) && ftruncate(info->fd, static_cast<off_t>(bytes)))
+        return nullptr;
+
+    /* pages are moved by the kernel without copying */
+    void *base = mremap(info, info->size, bytes, MREMAP_MAYMOVE);
+
+    /* can't grow */
+    if (base == MAP_FAILED)
+        return nullptr;
+
+    /* mapping might be moved */
+    info = reinterpret_cast<MappedInfo *>(base);
+    header = reinterpret_cast<BlockHeader *>(reinterpret_cast<char *>(base) + pageSize()) - 1;
+
+    /* update block size */
+    info->size = bytes;
+    header->capacity = capacity = bytes - pageSize();
+    return header + 1;
+#else
+    return nullptr;
+#endif
+}
+
+/****** Thread-local caches ******/
+
+struct Counters
+{
+    std::atomic<size_t> hits {0};
+    std::atomic<size_t> misses {0};
+    std::atomic<size_t> mapped {0};
+    std::atomic<size_t> oversized {0};
+};
+
+struct ThreadCache;
+struct CacheList
+{
+    std::mutex lock;
+    std::vector<ThreadCache *> caches;
+
+public:
+    /* counters of exited threads, and allocations after thread caches are destroyed */
+    Counters retired;
+
+};
+
+static CacheList &cacheList(void)
+{
+    static CacheList instance;
+    return instance;
+}
+
+static thread_local bool destroyed = false;
+static thread_local ThreadCache *current = nullptr;
+
+struct ThreadCache
+{
+    Counters counters;
+    size_t counts[BufferPool::ClassCount] = {};
+    FreeBlock *blocks[BufferPool::ClassCount] = {};
+
+public:
+    ThreadCache()
+    {
+        std::lock_guard<std::mutex> _(cacheList().lock);
+        cacheList().caches.push_back(this);
+        current = this;
+    }
+
+public:
+   ~ThreadCache()
+    {
+        /* releasing after this point goes to the system directly */
+        current = nullptr;
+        destroyed = true;
+
+        /* return all cached blocks */
+        for (FreeBlock *&block : blocks)
+        {
+            while (block)
+            {
+                FreeBlock *next = block->next;
+                freeBlock(headerOf(block));
+                block = next;
+            }
+        }
+
+        /* keep counters of this thread */
+        CacheList &list = cacheList();
+        std::lock_guard<std::mutex> _(list.lock);
+
+        list.retired.hits += counters.hits;
+        list.retired.misses += counters.misses;
+        list.retired.mapped += counters.mapped;
+        list.retired.oversized += counters.oversized;
+        list.caches.erase(std::find(list.caches.begin(), list.caches.end(), this));
+    }
+};
+
+static ThreadCache *threadCache(void)
+{
+    /* fast path, already created */
+    if (current != nullptr)
+        return current;
+
+    /* thread is exiting */
+    if (destroyed)
+        return nullptr;
+
+    /* create on first use */
+    static thread_local ThreadCache cache;
+    return &cache;
+}
+
+static inline void bump(ThreadCache *cache, std::atomic<size_t> Counters::*counter)
+{
+    /* thread caches are only written by their owners, so no need for atomic read-modify-write */
+    if (cache != nullptr)
+    {
+        std::atomic<size_t> &value = cache->counters.*counter;
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    else
+    {
+        /* retired counters are shared by all exiting threads */
+        (cacheList().retired.*counter).fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/****** Buffer pool ******/
+
+void *BufferPool::allocate(size_t size, size_t &capacity)
+{
+    BlockHeader *header;
+    ThreadCache *cache = threadCache();
+
+    /* very large blocks are mapped from the system */
+    if (size >= mapThreshold.load(std::memory_order_relaxed))
+    {
+        bump(cache, &Counters::mapped);
+        return mapAnonymous(size, capacity);
+    }
+
+    /* too large to be pooled */
+    if (size > classSize(ClassCount - 1))
+    {
+        /* allocate directly from the system */
+        if (!(header = reinterpret_cast<BlockHeader *>(malloc(sizeof(BlockHeader) + size))))
+            throw std::bad_alloc();
+
+        bump(cache, &Counters::oversized);
+        new (header) BlockHeader(BlockSource::Oversized, 0, capacity = size);
+        return header + 1;
+    }
+
+    /* find the size class */
+    Slab &s = slab();
+    size_t sizeClass = classOf(size);
+
+    /* the thread cache */
+    if (cache && cache->blocks[sizeClass])
+    {
+        FreeBlock *block = cache->blocks[sizeClass];
+        cache->blocks[sizeClass] = block->next;
+        cache->counts[sizeClass]--;
+
+        /* the count drops to zero when released by a shared reference */
+        bump(cache, &Counters::hits);
+        headerOf(block)->refs.store(1, std::memory_order_relaxed);
+        capacity = classSize(sizeClass);
+        return block;
+    }
+
+    /* the slab free list */
+    if (s.mem.load(std::memory_order_acquire))
+    {
+        std::unique_lock<std::mutex> lock(s.lock);
+        FreeBlock *block = s.blocks[sizeClass];
+
+        /* found in slab */
+        if (block != nullptr)
+        {
+            s.blocks[sizeClass] = block->next;
+            lock.unlock();
+
+            bump(cache, &Counters::hits);
+            headerOf(block)->refs.store(1, std::memory_order_relaxed);
+            capacity = classSize(sizeClass);
+            return block;
+        }
+    }
+
+    /* not cached */
+    size_t bytes = sizeof(BlockHeader) + classSize(sizeClass);
+    char *mem = s.mem.load(std::memory_order_acquire);
+
+    /* carve from slab if there is enough space */
+    if (mem && (s.used.load(std::memory_order_relaxed) + bytes <= s.size))
+    {
+        size_t offset = s.used.fetch_add(bytes);
+
+        /* space might be taken by other threads */
+        if (offset + bytes <= s.size)
+        {
+            bump(cache, &Counters::misses);
+            header = new (mem + offset) BlockHeader(BlockSource::Slab, sizeClass, capacity = classSize(sizeClass));
+            return header + 1;
+        }
+    }
+
+    /* allocate from the system */
+    if (!(header = reinterpret_cast<BlockHeader *>(malloc(bytes))))
+        throw std::bad_alloc();
+
+    bump(cache, &Counters::misses);
+    new (header) BlockHeader(BlockSource::Heap, sizeClass, capacity = classSize(sizeClass));
+    return header + 1;
+}
+
+void *BufferPool::reallocate(void *mem, size_t size, size_t &capacity)
+{
+    /* nothing to reallocate */
+    if (mem == nullptr)
+        return allocate(size, capacity);
+
+    /* still fits */
+    BlockHeader *header = headerOf(mem);
+    if (size <= header->capacity)
+    {
+        capacity = header->capacity;
+        return mem;
+    }
+
+    /* mapped blocks are remapped by the kernel, if not shared */
+    if ((header->source == BlockSource::Mapped) && !isShared(mem))
+    {
+        void *result = remapAnonymous(header, size, capacity);
+
+        /* fallback to copying if failed */
+        if (result != nullptr)
+            return result;
+    }
+
+    /* large blocks can be grown in place by the system, if not shared and not going to be mapped */
+    if ((header->source == BlockSource::Oversized) &&
+        (size > classSize(ClassCount - 1)) &&
+        (size < mapThreshold.load(std::memory_order_relaxed)) &&
+        !isShared(mem))
+    {
+        if (!(header = reinterpret_cast<BlockHeader *>(realloc(header, sizeof(BlockHeader) + size))))
+            throw std::bad_alloc();
+
+        header->capacity = capacity = size;
+        return header + 1;
+    }
+
+    /* move to a larger block */
+    void *result = allocate(size, capacity);
+    memcpy(result, mem, header->capacity);
+    release(mem);
+    return result;
+}
+
+void BufferPool::release(void *mem) noexcept
+{
+    /* nothing to release */
+    if (mem == nullptr)
+        return;
+
+    /* drop one reference, only the last one releases the block, skip the atomic operation if it's the only one */
+    BlockHeader *header = headerOf(mem);
+    if ((header->refs.load(std::memory_order_acquire) != 1) && (header->refs.fetch_sub(1, std::memory_order_acq_rel) != 1))
+        return;
+
+    /* large blocks are not cached */
+    switch (header->source)
+    {
+        case BlockSource::Heap:
+        case BlockSource::Slab:
+            break;
+
+        case BlockSource::Oversized:
+        {
+            free(header);
+            return;
+        }
+
+        case BlockSource::Mapped:
+        case BlockSource::MappedFile:
+        {
+            unmapBlock(header);
+            return;
+        }
+    }
+
+    /* cache in current thread if there is space left */
+    ThreadCache *cache = threadCache();
+    size_t sizeClass = header->sizeClass;
+
+    if (cache && (cache->counts[sizeClass] < std::max(CacheBlocks, CacheBytes / classSize(sizeClass))))
+    {
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(mem);
+        block->next = cache->blocks[sizeClass];
+        cache->blocks[sizeClass] = block;
+        cache->counts[sizeClass]++;
+        return;
+    }
+
+    /* cache is full */
+    freeBlock(header);
+}
+
+void BufferPool::retain(void *mem) noexcept
+{
+    if (mem != nullptr)
+        headerOf(mem)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BufferPool::isShared(const void *mem) noexcept
+{
+    return mem && (headerOf(mem)->refs.load(std::memory_order_acquire) > 1);
+}
+
+bool BufferPool::isReadOnly(const void *mem) noexcept
+{
+    return mem && (headerOf(mem)->source == BlockSource::MappedFile);
+}
+
+size_t BufferPool::capacityOf(const void *mem) noexcept
+{
+    return mem ? headerOf(mem)->capacity : 0;
+}
+
+int BufferPool::descriptorOf(const void *mem, off_t &offset) noexcept
+{
+    BlockHeader *header;
+
+    /* only mapped blocks have backing files */
+    if (!mem || (((header = headerOf(mem))->source != BlockSource::Mapped) && (header->source != BlockSource::MappedFile)))
+        return -1;
+
+    /* position of the payload */
+    offset = infoOf(header)->offset;
+    return infoOf(header)->fd;
+}
+
+void BufferPool::setMapThreshold(size_t size)
+{
+    mapThreshold.store(size, std::memory_order_relaxed);
+}
+
+void *BufferPool::mapFile(int fd, size_t size, size_t &capacity)
+{
+    size_t bytes = pageSize() + roundPages(size);
+    void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    /* reserve address space for the info page and the file */
+    if (base == MAP_FAILED)
+        throw std::bad_alloc();
+
+    /* map the file right after the info page, read-only */
+    char *mem = reinterpret_cast<char *>(base);
+    if (size && (mmap(mem + pageSize(), size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED))
+    {
+        int error = errno;
+        munmap(base, bytes);
+        throw Exceptions::RuntimeError(std::string("Cannot map file : ") + strerror(error));
+    }
+
+    /* keep a descriptor of our own for `sendfile` */
+    int dupfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+    /* can still be used without it */
+    bump(threadCache(), &Counters::mapped);
+    return initMapped(mem, BlockSource::MappedFile, dupfd, 0, bytes, capacity = size) + 1;
+}
+
+BufferPool::Stats BufferPool::stats(void)
+{
+    Stats result;
+    Slab &s = slab();
+    CacheList &list = cacheList();
+    std::lock_guard<std::mutex> _(list.lock);
+
+    /* exited threads */
+    result.hits = list.retired.hits;
+    result.misses = list.retired.misses;
+    result.mapped = list.retired.mapped;
+    result.oversized = list.retired.oversized;
+
+    /* live threads */
+    for (ThreadCache *cache : list.caches)
+    {
+        result.hits += cache->counters.hits.load(std::memory_order_relaxed);
+        result.misses += cache->counters.misses.load(std::memory_order_relaxed);
+        result.mapped += cache->counters.mapped.load(std::memory_order_relaxed);
+        result.oversized += cache->counters.oversized.load(std::memory_order_relaxed);
+    }
+
+    /* `used` may overshoot when the slab is exhausted */
+    result.slabSize = s.size;
+    result.slabUsed = std::min(s.used.load(), s.size);
+    return result;
+}
+
+bool BufferPool::reserveSlab(size_t size)
+{
+    Slab &s = slab();
+    std::lock_guard<std::mutex> _(s.lock);
+
+    /* already reserved */
+    if (s.mem.load())
+        return true;
+
+    /* round up to huge pages */
+    size = (size + HugePageSize - 1) / HugePageSize * HugePageSize;
+    void *mem = MAP_FAILED;
+
+#if defined(MAP_HUGETLB)
+    /* explicit huge pages, requires pages reserved by the system */
+    mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    /* fallback to normal pages */
+    if (mem == MAP_FAILED)
+    {
+        if ((mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+            return false;
+
+#if defined(MADV_HUGEPAGE)
+        /* transparent huge pages, just a hint */
+        madvise(mem, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    /* publish the slab, it's never unmapped */
+    s.size = size;
+    s.mem.store(reinterpret_cast<char *>(mem), std::memory_order_release);
+    return true;
+}
+}
@@ -0,0 +1,239 @@
+#include <utility>
+
+#include <unistd.h>
+
+#include "ByteRope.h"
+#include "BufferPool.h"
+#include "Exceptions.h"
+
+namespace SimpleRPC
+{
+void ByteRope::swap(ByteRope &other)
+{
+    std::swap(_length, other._length);
+    std::swap(_segments, other._segments);
+    std::swap(_segmentSize, other._segmentSize);
+}
+
+void ByteRope::clear(void)
+{
+    for (const auto &segment : _segments)
+        BufferPool::release(segment.mem);
+
+    _length = 0;
+    _segments.clear();
+}
+
+void ByteRope::consume(size_t size)
+{
+    /* avoid buffer overflow */
+    if (size > _length)
+        throw Exceptions::BufferOverflowError(_length);
+
+    /* drop the consumed bytes */
+    _length -= size;
+    while (size)
+    {
+        Segment &segment = _segments.front();
+        size_t n = std::min(size, segment.end - segment.begin);
+
+        /* partially consumed */
+        size -= n;
+        segment.begin += n;
+
+        /* segment is drained, release it */
+        if (segment.begin == segment.end)
+        {
+            BufferPool::release(segment.mem);
+            _segments.pop_front();
+        }
+    }
+}
+
+ByteRope::Segment &ByteRope::allocate(size_t capacity, bool front)
+{
+    Segment segment;
+    segment.mem = reinterpret_cast<char *>(BufferPool::allocate(capacity, segment.capacity));
+
+    /* segments for prepending are filled from the end */
+    segment.begin = front ? segment.capacity : 0;
+    segment.end = segment.begin;
+
+    /* add to chain */
+    if (front)
+    {
+        _segments.push_front(segment);
+        return _segments.front();
+    }
+    else
+    {
+        _segments.push_back(segment);
+        return _segments.back();
+    }
+}
+
+void ByteRope::append(const void *data, size_t size)
+{
+    const char *p = reinterpret_cast<const char *>(data);
+
+    /* fill the tail of the last segment first, then new segments */
+    _length += size;
+    while (size)
+    {
+        Segment *segment = _segments.empty() ? nullptr : &_segments.back();
+
+        /* no space left in the last segment */
+        if ((segment == nullptr) || (segment->end == segment->capacity))
+            segment = &allocate(_segmentSize, false);
+
+        /* copy as much as we can */
+        size_t n = std::min(size, segment->capacity - segment->end);
+        memcpy(segment->mem + segment->end, p, n);
+
+        p += n;
+        size -= n;
+        segment->end += n;
+    }
+}
+
+void ByteRope::prepend(const void *data, size_t size)
+{
+    const char *p = reinterpret_cast<const char *>(data) + size;
+
+    /* fill the head room of the first segment first, then new segments, backwards */
+    _length += size;
+    while (size)
+    {
+        Segment *segment = _segments.empty() ? nullptr : &_segments.front();
+
+        /* no head room in the first segment */
+        if ((segment == nullptr) || (segment->begin == 0))
+            segment = &allocate(_segmentSize, true);
+
+        /* copy as much as we can */
+        size_t n = std::min(size, segment->begin);
+        memcpy(segment->mem + segment->begin - n, p - n, n);
+
+        p -= n;
+        size -= n;
+        segment->begin -= n;
+    }
+}
+
+std::vector<struct iovec> ByteRope::iovecs(size_t limit) const
+{
+    std::vector<struct iovec> result;
+    result.reserve(std::min(limit, _segments.size()));
+
+    /* every non-empty segment */
+    for (const auto &segment : _segments)
+    {
+        /* enough vectors */
+        if (result.size() >= limit)
+            break;
+
+        /* segments never stay empty, except the ones just allocated */
+        if (segment.begin != segment.end)
+            result.push_back({ segment.mem + segment.begin, segment.end - segment.begin });
+    }
+
+    return result;
+}
+
+ssize_t ByteRope::writeTo(int fd)
+{
+    /* writes at most `IOV_MAX` segments at once */
+    std::vector<struct iovec> iov = iovecs();
+    ssize_t ret = writev(fd, iov.data(), static_cast<int>(iov.size()));
+
+    /* drop written bytes */
+    if (ret > 0)
+        consume(static_cast<size_t>(ret));
+
+    return ret;
+}
+
+ssize_t ByteRope::readFrom(int fd, size_t size)
+{
+    size_t space = 0;
+    std::vector<struct iovec> iov;
+
+    /* free space of the last segment */
+    if (!_segments.empty() && (_segments.back().end < _segments.back().capacity))
+    {
+        Segment &segment = _segments.back();
+        space = segment.capacity - segment.end;
+        iov.push_back({ segment.mem + segment.end, space });
+    }
+
+    /* new segments for the rest */
+    while ((space < size) && (iov.size() < static_cast<size_t>(IOV_MAX)))
+    {
+        Segment &segment = allocate(_segmentSize, false);
+        space += segment.capacity;
+        iov.push_back({ segment.mem, segment.capacity });
+    }
+
+    /* don't read more than required */
+    if (space > size)
+        iov.back().iov_len -= space - size;
+
+    /* fill the segments in one call */
+    ssize_t ret = readv(fd, iov.data(), static_cast<int>(iov.size()));
+
+    /* I/O vectors map to the last segments in order */
+    size_t first = _segments.size() - iov.size();
+    size_t remains = ret > 0 ? static_cast<size_t>(ret) : 0;
+
+    /* commit bytes to each segment */
+    _length += remains;
+    for (size_t i = 0; remains; i++)
+    {
+        size_t n = std::min(remains, iov[i].iov_len);
+        remains -= n;
+        _segments[first + i].end += n;
+    }
+
+    /* release segments that received nothing */
+    while (!_segments.empty() && (_segments.back().begin == _segments.back().end))
+    {
+        BufferPool::release(_segments.back().mem);
+        _segments.pop_back();
+    }
+
+    return ret;
+}
+
+size_t ByteRope::copyTo(void *data, size_t size) const
+{
+    char *p = reinterpret_cast<char *>(data);
+    size_t copied = 0;
+
+    /* copy segment by segment */
+    for (const auto &segment : _segments)
+    {
+        size_t n = std::min(size - copied, segment.end - segment.begin);
+        memcpy(p + copied, segment.mem + segment.begin, n);
+
+        /* buffer is full */
+        if ((copied += n) == size)
+            break;
+    }
+
+    return copied;
+}
+
+ByteSeq ByteRope::toByteSeq(void) const
+{
+    ByteSeq result;
+    result.commit(copyTo(result.preserve(_length), _length));
+    return result;
+}
+
+std::string ByteRope::toString(void) const
+{
+    std::string result(_length, 0);
+    copyTo(&result[0], _length);
+    return result;
+}
+}
@@ -1,5 +1,20 @@
 #include <utility>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+#if defined(__x86_64__)
+#include <tmmintrin.h>
+#endif
+
 #include "ByteSeq.h"
+#include "BufferPool.h"
 #include "Exceptions.h"
 
 namespace SimpleRPC
@@ -12,20 +27,124 @@ void ByteSeq::swap(ByteSeq &other)
     std::swap(_capacity, other._capacity);
 }
 
+ByteSeq ByteSeq::slice(size_t offset, size_t size) const
+{
+    ByteSeq result;
+
+    /* avoid buffer overflow */
+    if ((offset > _length) || (size > _length - offset))
+        throw Exceptions::BufferOverflowError(_length);
+
+    /* nothing to share */
+    if (_mem == nullptr)
+        return result;
+
+    /* refer to the same buffer */
+    BufferPool::retain(_mem);
+    result._mem = _mem;
+    result._length = size;
+    result._capacity = _capacity;
+    result._readptr = _readptr + offset;
+    return result;
+}
+
+ByteSeq ByteSeq::consumeSlice(size_t size)
+{
+    ByteSeq result = slice(0, size);
+    consume(size);
+    return result;
+}
+
+ByteSeq ByteSeq::mapFile(const std::string &path)
+{
+    int fd;
+    struct stat st;
+
+    /* open the file for reading */
+    if ((fd = open(path.c_str(), O_RDONLY | O_CLOEXEC)) < 0)
+        throw Exceptions::RuntimeError("Cannot open file \"" + path + "\" : " + strerror(errno));
+
+    /* find out it's size */
+    if (fstat(fd, &st) < 0)
+    {
+        int error = errno;
+        close(fd);
+        throw Exceptions::RuntimeError("Cannot stat file \"" + path + "\" : " + strerror(error));
+    }
+
+    ByteSeq result;
+    size_t size = static_cast<size_t>(st.st_size);
+
+    /* the pool keeps it's own descriptor */
+    try
+    {
+        result._mem = reinterpret_cast<char *>(BufferPool::mapFile(fd, size, result._capacity));
+        result._length = size;
+        result._readptr = result._mem;
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+
+    close(fd);
+    return result;
+}
+
+ssize_t ByteSeq::sendTo(int fd)
+{
+    ssize_t ret;
+
+#if defined(__linux__)
+    off_t offset;
+    int source = BufferPool::descriptorOf(_mem, offset);
+
+    /* mapped buffers are sent by the kernel directly from their backing files */
+    if (source >= 0)
+    {
+        offset += _readptr - _mem;
+        ret = sendfile(fd, source, &offset, _length);
+    }
+    else
+#endif
+    {
+        ret = write(fd, _readptr, _length);
+    }
+
+    /* drop written bytes */
+    if (ret > 0)
+    {
+        _length -= static_cast<size_t>(ret);
+        _readptr += ret;
+    }
+
+    return ret;
+}
+
 void ByteSeq::clear(void)
 {
     _length = 0;
     _readptr = _mem;
 }
 
-char *ByteSeq::consume(size_t size)
+char *ByteSeq::mutableData(void)
+{
+    /* `preserve` unshares the buffer */
+    if (BufferPool::isShared(_mem) || BufferPool::isReadOnly(_mem))
+        preserve(0);
+
+    return _readptr;
+}
+
+const char *ByteSeq::consume(size_t size)
 {
     /* no data left */
     if (!_length)
         throw Exceptions::BufferOverflowError(_length);
 
     /* current position is the start position of read */
-    char *result = _readptr;
+    const char *result = _readptr;
 
     /* avoid buffer overflow */
     if (size > _length)
@@ -37,11 +156,43 @@ char *ByteSeq::consume(size_t size)
     return result;
 }
 
+void ByteSeq::truncate(size_t length)
+{
+    /* can't grow by truncating */
+    if (length > _length)
+        throw Exceptions::BufferOverflowError(_length);
+
+    /* data before read pointer is not affected */
+    _length = length;
+}
+
 char *ByteSeq::preserve(size_t size)
 {
     /* flags for resize */
     bool resize = false;
 
+    /* buffer is shared with slices, or mapped from a file, copy before writing to it */
+    if (BufferPool::isShared(_mem) || BufferPool::isReadOnly(_mem))
+    {
+        size_t capacity = 32;
+
+        /* grow geometrically like unshared buffers, instead of fitting exactly and copying again on the next append */
+        while (capacity < _length + size)
+            capacity *= 2;
+
+        char *mem = reinterpret_cast<char *>(BufferPool::allocate(capacity, capacity));
+
+        /* only data of this sequence */
+        memcpy(mem, _readptr, _length);
+        BufferPool::release(_mem);
+
+        /* the new buffer is large enough */
+        _mem = mem;
+        _readptr = mem;
+        _capacity = capacity;
+        return _readptr + _length;
+    }
+
     /* find smallest size we need */
     while (size > _capacity - _length)
     {
@@ -55,8 +206,8 @@ char *ByteSeq::preserve(size_t size)
         /* if neither resize needed, do nothing */
         if (resize)
         {
-            /* simply realloc */
-            _mem = reinterpret_cast<char *>(realloc(_mem, _capacity));
+            /* simply realloc, the pool might give more space than required */
+            _mem = reinterpret_cast<char *>(BufferPool::reallocate(_mem, _capacity, _capacity));
             _readptr = _mem;
         }
         else if (_readptr == nullptr)
@@ -65,7 +216,7 @@ char *ByteSeq::preserve(size_t size)
             if (_mem == nullptr)
             {
                 /* simply allocate a new buffer */
-                _mem = reinterpret_cast<char *>(malloc(_capacity));
+                _mem = reinterpret_cast<char *>(BufferPool::allocate(_capacity, _capacity));
                 _readptr = _mem;
             }
             else
@@ -91,11 +242,11 @@ char *ByteSeq::preserve(size_t size)
         else
         {
             /* allocate another new space */
-            void *newSpace = malloc(_capacity);
+            void *newSpace = BufferPool::allocate(_capacity, _capacity);
 
             /* discard data that already consumed */
             memcpy(newSpace, _readptr, _length);
-            free(_mem);
+            BufferPool::release(_mem);
 
             /* reset readptr and memory pointer */
             _mem = reinterpret_cast<char *>(newSpace);
@@ -114,6 +265,240 @@ void ByteSeq::append(const void *data, size_t size)
     commit(size);
 }
 
+/****** Varints ******/
+
+/* a varint is at most 10 bytes for 64-bit values */
+static const size_t MaxVarIntSize = 10;
+
+static inline size_t encodeVarUInt(uint8_t *p, uint64_t value)
+{
+    size_t size = 0;
+
+    /* 7 bits at a time, high bit set on all but the last byte */
+    while (value >= 0x80)
+    {
+        p[size++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+
+    p[size++] = static_cast<uint8_t>(value);
+    return size;
+}
+
+static size_t decodeVarUIntSlow(const uint8_t *p, size_t size, uint64_t &value)
+{
+    value = 0;
+
+    /* byte by byte */
+    for (size_t i = 0; i < std::min(size, MaxVarIntSize); i++)
+    {
+        /* the 10th byte only has 1 bit left */
+        if ((i == MaxVarIntSize - 1) && (p[i] > 1))
+            throw Exceptions::DeserializerError("Varint overflow");
+
+        /* last byte */
+        value |= static_cast<uint64_t>(p[i] & 0x7f) << (i * 7);
+        if (!(p[i] & 0x80))
+            return i + 1;
+    }
+
+    /* all bytes have the continuation bit */
+    if (size < MaxVarIntSize)
+        throw Exceptions::DeserializerError("Truncated varint");
+    else
+        throw Exceptions::DeserializerError("Varint is too long");
+}
+
+static inline size_t decodeVarUInt(const uint8_t *p, size_t size, uint64_t &value)
+{
+    uint64_t word;
+    uint64_t stops;
+
+    /* not enough bytes to load a whole word */
+    if (size < sizeof(uint64_t))
+        return decodeVarUIntSlow(p, size, value);
+
+    /* bytes without the continuation bit */
+    memcpy(&word, p, sizeof(uint64_t));
+    stops = ~word & 0x8080808080808080ull;
+
+    /* longer than 8 bytes, which only happens to values not less than 2^56 */
+    if (!stops)
+        return decodeVarUIntSlow(p, size, value);
+
+    /* keep only the bytes of this varint, by masking everything above the first stop bit */
+    size_t length = (__builtin_ctzll(stops) >> 3) + 1;
+    word &= (stops ^ (stops - 1)) & 0x7f7f7f7f7f7f7f7full;
+
+    /* squeeze out the continuation bits, by merging 7-bit groups into 14, 28, then 56 bits */
+    word = ((word & 0x7f007f007f007f00ull) >> 1) | (word & 0x007f007f007f007full);
+    word = ((word & 0x3fff00003fff0000ull) >> 2) | (word & 0x00003fff00003fffull);
+    word = ((word & 0x0fffffff00000000ull) >> 4) | (word & 0x000000000fffffffull);
+
+    value = word;
+    return length;
+}
+
+void ByteSeq::appendVarUInt(uint64_t value)
+{
+    commit(encodeVarUInt(reinterpret_cast<uint8_t *>(preserve(MaxVarIntSize)), value));
+}
+
+void ByteSeq::appendVarUInts(const uint64_t *data, size_t count)
+{
+    size_t size = 0;
+    uint8_t *p = reinterpret_cast<uint8_t *>(preserve(MaxVarIntSize * count));
+
+    /* reserve for the worst case, commit only what is used */
+    for (size_t i = 0; i < count; i++)
+        size += encodeVarUInt(p + size, data[i]);
+
+    commit(size);
+}
+
+void ByteSeq::appendVarInts(const int64_t *data, size_t count)
+{
+    size_t size = 0;
+    uint8_t *p = reinterpret_cast<uint8_t *>(preserve(MaxVarIntSize * count));
+
+    /* same as unsigned ones, with zigzag */
+    for (size_t i = 0; i < count; i++)
+        size += encodeVarUInt(p + size, zigzag(data[i]));
+
+    commit(size);
+}
+
+uint64_t ByteSeq::nextVarUInt(void)
+{
+    uint64_t value;
+    consume(decodeVarUInt(reinterpret_cast<const uint8_t *>(_readptr), _length, value));
+    return value;
+}
+
+void ByteSeq::nextVarUInts(uint64_t *data, size_t count)
+{
+    size_t size = 0;
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(_readptr);
+
+    /* decode all, then consume once */
+    for (size_t i = 0; i < count; i++)
+        size += decodeVarUInt(p + size, _length - size, data[i]);
+
+    if (size)
+        consume(size);
+}
+
+void ByteSeq::nextVarInts(int64_t *data, size_t count)
+{
+    size_t size = 0;
+    uint64_t value;
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(_readptr);
+
+    /* same as unsigned ones, with zigzag */
+    for (size_t i = 0; i < count; i++)
+    {
+        size += decodeVarUInt(p + size, _length - size, value);
+        data[i] = unzigzag(value);
+    }
+
+    if (size)
+        consume(size);
+}
+
+/****** Byte swapping ******/
+
+template <typename T, T (*Swap)(T)>
+static inline void swapScalar(char *dest, const char *src, size_t count)
+{
+    T value;
+
+    /* element by element */
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(&value, src + i * sizeof(T), sizeof(T));
+        value = Swap(value);
+        memcpy(dest + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+static inline uint16_t bswap16(uint16_t value) { return __builtin_bswap16(value); }
+static inline uint32_t bswap32(uint32_t value) { return __builtin_bswap32(value); }
+static inline uint64_t bswap64(uint64_t value) { return __builtin_bswap64(value); }
+
+static void swapSoftware(char *dest, const char *src, size_t size, size_t count)
+{
+    switch (size)
+    {
+        case 2 : swapScalar<uint16_t, bswap16>(dest, src, count); break;
+        case 4 : swapScalar<uint32_t, bswap32>(dest, src, count); break;
+        case 8 : swapScalar<uint64_t, bswap64>(dest, src, count); break;
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("ssse3")))
+static void swapHardware(char *dest, const char *src, size_t size, size_t count)
+{
+    __m128i mask;
+    size_t bytes = size * count;
+
+    /* shuffle masks that reverse every element in a 16-byte lane */
+    switch (size)
+    {
+        case 2  : mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14); break;
+        case 4  : mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12); break;
+        default : mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8); break;
+    }
+
+    /* 16 bytes at a time */
+    while (bytes >= sizeof(__m128i))
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_shuffle_epi8(value, mask));
+
+        src += sizeof(__m128i);
+        dest += sizeof(__m128i);
+        bytes -= sizeof(__m128i);
+    }
+
+    /* the remaining elements */
+    swapSoftware(dest, src, size, bytes / size);
+}
+#endif
+
+void ByteSeq::swapBytes(void *dest, const void *src, size_t size, size_t count)
+{
+    char *p = reinterpret_cast<char *>(dest);
+    const char *q = reinterpret_cast<const char *>(src);
+
+    /* nothing to swap for bytes */
+    if (size == 1)
+    {
+        memcpy(p, q, count);
+        return;
+    }
+
+    /* elements of unusual sizes are reversed one by one */
+    if ((size != 2) && (size != 4) && (size != 8))
+    {
+        for (size_t i = 0; i < count; i++)
+            std::reverse_copy(q + i * size, q + i * size + size, p + i * size);
+
+        return;
+    }
+
+#if defined(__x86_64__)
+    /* detect CPU features only once */
+    static const auto impl = __builtin_cpu_supports("ssse3") ? swapHardware : swapSoftware;
+#else
+    static const auto impl = swapSoftware;
+#endif
+
+    impl(p, q, size, count);
+}
+
+/****** Debugging helpers ******/
+
 std::string ByteSeq::repr(const void *data, size_t size)
 {
     if (!data)
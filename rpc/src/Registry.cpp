@@ -1,3 +1,7 @@
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
 #include "Variant.h"
 #include "Registry.h"
 #include "Inspector.h"
@@ -5,29 +9,369 @@
 
 namespace SimpleRPC
 {
-/* class factory registry */
-static inline std::unordered_map<std::string, std::shared_ptr<Registry::Meta>> &registry(void)
+/* objects with no more fields than this decode into slots on the stack */
+static const size_t StackSlots = 64;
+
+/* seeds to try for each table size before doubling it */
+static const uint64_t MaxSeeds = 64;
+
+static inline size_t bucketOf(uint64_t hash, uint64_t seed, size_t size)
+{
+    /* mix the seed in, and fold high bits down, since only the low bits are used */
+    hash ^= seed * 0x9e3779b97f4a7c15ull;
+    hash *= 0xff51afd7ed558ccdull;
+    return (hash ^ (hash >> 32)) & (size - 1);
+}
+
+static uint64_t perfectHash(const std::vector<uint64_t> &hashes, std::vector<int32_t> &index)
 {
-    static std::unordered_map<std::string, std::shared_ptr<Registry::Meta>> instance;
+    std::vector<uint64_t> sorted(hashes);
+    std::sort(sorted.begin(), sorted.end());
+
+    /* equal hashes can never be separated */
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        throw Exceptions::ReflectionError("Names with colliding hashes");
+
+    /* smallest power of two that holds all names */
+    size_t size = 1;
+    while (size < hashes.size())
+        size <<= 1;
+
+    /* search for a seed without collisions, grow the table if none found */
+    for (;; size <<= 1)
+    {
+        for (uint64_t seed = 0; seed < MaxSeeds; seed++)
+        {
+            bool collided = false;
+            index.assign(size, -1);
+
+            for (size_t i = 0; !collided && (i < hashes.size()); i++)
+            {
+                int32_t &slot = index[bucketOf(hashes[i], seed, size)];
+
+                /* bucket already taken */
+                if (slot >= 0)
+                    collided = true;
+                else
+                    slot = static_cast<int32_t>(i);
+            }
+
+            /* found a perfect hash */
+            if (!collided)
+                return seed;
+        }
+    }
+}
+
+uint64_t Registry::hashOf(const char *name, size_t length)
+{
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<uint8_t>(name[i]);
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+Registry::Meta::Meta(
+    std::string    &&name,
+    FieldList      &&fields,
+    MethodMap      &&methods,
+    Constructor    &&constructor,
+    const Codec     &codec
+) : _fieldList(std::move(fields)),
+    _methods(std::move(methods)),
+    _constructor(std::move(constructor)),
+    _seed(0),
+    _hash(0),
+    _layout(0),
+    _codec(codec),
+    _name(std::move(name))
+{
+    /* hash the stored name, the argument has been moved from */
+    _hash = hashOf(_name);
+
+    std::string layout;
+    std::vector<uint64_t> hashes;
+    hashes.reserve(_fieldList.size());
+
+    /* fields by name, and the layout of packed records */
+    for (const auto &field : _fieldList)
+    {
+        layout += field->name() + ":" + field->type().toSignature() + ";";
+        hashes.push_back(hashOf(field->name()));
+        _fields.emplace(field->name(), field);
+    }
+
+    /* fingerprint of the layout, and index of fields by name */
+    _layout = hashOf(layout);
+    _seed = perfectHash(hashes, _index);
+}
+
+ssize_t Registry::Meta::indexOf(const char *name, size_t length) const
+{
+    /* class without fields */
+    if (_fieldList.empty())
+        return -1;
+
+    /* the bucket might hold a different field, or nothing */
+    int32_t slot = _index[bucketOf(hashOf(name, length), _seed, _index.size())];
+    return ((slot >= 0) && (_fieldList[slot]->name().compare(0, std::string::npos, name, length) == 0)) ? slot : -1;
+}
+
+/****** Class registry ******/
+
+/* registered class, meta data is built on first use, `built` is the published pointer and `meta` keeps it alive */
+struct ClassEntry
+{
+    uint64_t hash;
+    std::string name;
+    Registry::Builder builder;
+    std::shared_ptr<Registry::Meta> meta;
+    std::atomic<Registry::MetaPtr> built {nullptr};
+};
+
+/* immutable snapshot of all registered classes, indexed by a perfect hash of their names */
+struct ClassTable
+{
+    uint64_t seed;
+    std::vector<int32_t> index;
+    std::vector<ClassEntry *> classes;
+};
+
+/* classes are queued under the lock, and published as a new table on the next lookup
+ * old tables are kept, since readers might still be using them, classes rarely appear after startup */
+struct ClassRegistry
+{
+    std::mutex lock;
+    std::atomic<const ClassTable *> table {nullptr};
+    std::vector<std::unique_ptr<const ClassTable>> tables;
+
+public:
+    std::vector<std::pair<const char *, Registry::Builder>> pending;
+    std::unordered_map<uint64_t, std::unique_ptr<ClassEntry>> classes;
+};
+
+/* use function wrapper to get rid of the initialization order problem */
+static inline ClassRegistry &registry(void)
+{
+    static ClassRegistry instance;
     return instance;
 }
 
-void Registry::addClass(std::shared_ptr<Registry::Meta> &&meta)
+static const ClassTable *freeze(void)
 {
-    if (registry().find(meta->name()) == registry().end())
-        registry().emplace(meta->name(), std::move(meta));
+    ClassRegistry &reg = registry();
+    std::lock_guard<std::mutex> _(reg.lock);
+
+    /* published by another thread */
+    if (const ClassTable *table = reg.table.load(std::memory_order_acquire))
+        return table;
+
+    /* class names are only generated here, not during static initialization */
+    for (const auto &item : reg.pending)
+    {
+        std::string name = Type(Type::TypeCode::Object, item.first, false).toSignature();
+        uint64_t hash = Registry::hashOf(name);
+        auto iter = reg.classes.find(hash);
+
+        /* classes defined in headers are registered by every translation unit */
+        if (iter != reg.classes.end())
+        {
+            /* hashes must be unique, since lookups by hash never compare names */
+            if (iter->second->name != name)
+                throw Exceptions::ReflectionError("Class \"" + name + "\" has the same hash as \"" + iter->second->name + "\"");
+
+            continue;
+        }
+
+        std::unique_ptr<ClassEntry> entry(new ClassEntry);
+        entry->hash = hash;
+        entry->name = std::move(name);
+        entry->builder = item.second;
+        reg.classes.emplace(hash, std::move(entry));
+    }
+
+    std::vector<uint64_t> hashes;
+    std::unique_ptr<ClassTable> table(new ClassTable);
+
+    /* snapshot of current classes */
+    reg.pending.clear();
+    hashes.reserve(reg.classes.size());
+    table->classes.reserve(reg.classes.size());
+
+    for (const auto &item : reg.classes)
+    {
+        hashes.push_back(item.first);
+        table->classes.push_back(item.second.get());
+    }
+
+    /* build the index and publish it */
+    table->seed = perfectHash(hashes, table->index);
+    reg.table.store(table.get(), std::memory_order_release);
+    reg.tables.push_back(std::move(table));
+    return reg.tables.back().get();
+}
+
+static inline ClassEntry *lookup(uint64_t hash)
+{
+    const ClassTable *table = registry().table.load(std::memory_order_acquire);
+
+    /* classes were added since last lookup */
+    if (table == nullptr)
+        table = freeze();
+
+    /* no classes at all */
+    if (table->classes.empty())
+        return nullptr;
+
+    /* the bucket might hold a different class, or nothing */
+    int32_t slot = table->index[bucketOf(hash, table->seed, table->index.size())];
+    return ((slot >= 0) && (table->classes[slot]->hash == hash)) ? table->classes[slot] : nullptr;
+}
+
+static Registry::MetaClass build(ClassEntry *entry)
+{
+    /* built without holding the registry lock, since builders might look up other classes */
+    Registry::MetaPtr expected = nullptr;
+    std::shared_ptr<Registry::Meta> meta = entry->builder();
+
+    /* another thread might have built it first, the one that loses the race is dropped */
+    if (!entry->built.compare_exchange_strong(expected, meta.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+        return *expected;
+
+    /* only the winner owns it, nothing else writes this */
+    entry->meta = std::move(meta);
+    return *entry->meta;
+}
+
+static inline Registry::MetaClass materialize(ClassEntry *entry)
+{
+    /* meta data is built exactly once, on first use */
+    if (Registry::MetaPtr meta = entry->built.load(std::memory_order_acquire))
+        return *meta;
+    else
+        return build(entry);
+}
+
+void Registry::addClass(const char *type, Builder builder)
+{
+    ClassRegistry &reg = registry();
+    std::lock_guard<std::mutex> _(reg.lock);
+
+    /* the current table is outdated */
+    reg.pending.emplace_back(type, builder);
+    reg.table.store(nullptr, std::memory_order_release);
+}
+
+Registry::MetaClass Registry::findClass(uint64_t hash)
+{
+    if (ClassEntry *entry = lookup(hash))
+        return materialize(entry);
+    else
+        throw Exceptions::ClassNotFoundError("#" + std::to_string(hash));
 }
 
 Registry::MetaClass Registry::findClass(const std::string &name)
 {
-    if (registry().find(name) != registry().end())
-        return *registry().at(name);
+    ClassEntry *entry = lookup(hashOf(name));
+
+    /* hashes are unique among registered classes, but unknown names might still collide */
+    if (entry && (entry->name == name))
+        return materialize(entry);
     else
         throw Exceptions::ClassNotFoundError(name);
 }
 
+static Variant unpackScalar(Type::TypeCode type, const char *&data)
+{
+    union
+    {
+        int8_t   s8;
+        int16_t  s16;
+        int32_t  s32;
+        int64_t  s64;
+        uint8_t  u8;
+        uint16_t u16;
+        uint32_t u32;
+        uint64_t u64;
+        bool     b;
+        float    f;
+        double   d;
+    } value;
+
+    /* packed fields are in native byte order */
+    switch (type)
+    {
+        case Type::TypeCode::Int8    : memcpy(&value, data, sizeof(int8_t  )); data += sizeof(int8_t  ); return value.s8;
+        case Type::TypeCode::Int16   : memcpy(&value, data, sizeof(int16_t )); data += sizeof(int16_t ); return value.s16;
+        case Type::TypeCode::Int32   : memcpy(&value, data, sizeof(int32_t )); data += sizeof(int32_t ); return value.s32;
+        case Type::TypeCode::Int64   : memcpy(&value, data, sizeof(int64_t )); data += sizeof(int64_t ); return value.s64;
+        case Type::TypeCode::UInt8   : memcpy(&value, data, sizeof(uint8_t )); data += sizeof(uint8_t ); return value.u8;
+        case Type::TypeCode::UInt16  : memcpy(&value, data, sizeof(uint16_t)); data += sizeof(uint16_t); return value.u16;
+        case Type::TypeCode::UInt32  : memcpy(&value, data, sizeof(uint32_t)); data += sizeof(uint32_t); return value.u32;
+        case Type::TypeCode::UInt64  : memcpy(&value, data, sizeof(uint64_t)); data += sizeof(uint64_t); return value.u64;
+        case Type::TypeCode::Float   : memcpy(&value, data, sizeof(float   )); data += sizeof(float   ); return value.f;
+        case Type::TypeCode::Double  : memcpy(&value, data, sizeof(double  )); data += sizeof(double  ); return value.d;
+        case Type::TypeCode::Boolean : value.b = (*data != 0);                  data += sizeof(bool    ); return value.b;
+
+        default:
+        {
+            /* would NEVER happens, packable classes only have primitive fields */
+            abort();
+        }
+    }
+}
+
+void Variant::PackedLoader::load(Variant &value) const
+{
+    size_t size = meta->packedSize();
+    const char *p = data.data();
+
+    /* array items are deferred again, as slices of the same buffer */
+    if (value.type() == Type::TypeCode::Array)
+    {
+        Variant::Array &array = value.internalArray();
+        array.reserve(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            array.push_back(std::make_shared<Variant>(
+                Type::TypeCode::Object,
+                std::make_shared<PackedLoader>(meta, data.slice(i * size, size), 1)
+            ));
+        }
+
+        return;
+    }
+
+    /* fields are in the order of field list */
+    Variant::Object &object = value.internalObject();
+    object.reserve(meta->fieldList().size());
+
+    for (const auto &field : meta->fieldList())
+        object.emplace(field->name(), std::make_shared<Variant>(unpackScalar(field->type().typeCode(), p)));
+}
+
 Variant Serializable::serialize(void) const
 {
+    /* packable classes are packed into a single record */
+    if (_meta->packer())
+    {
+        ByteSeq data;
+        _meta->packer()(this, data.preserve(_meta->packedSize()));
+        data.commit(_meta->packedSize());
+        return Variant(Type::TypeCode::Object, std::make_shared<Variant::PackedLoader>(_meta, std::move(data), 1));
+    }
+
+    /* generated serializer reads fields directly */
+    if (_meta->serializer())
+        return _meta->serializer()(this);
+
     /* create object type */
     Variant result(Type::TypeCode::Object);
     Variant::Object &fields = result.internalObject();
@@ -41,29 +385,65 @@ Variant Serializable::serialize(void) const
 }
 
 void Serializable::deserialize(Variant &&value)
+{
+    /* values are copied out from the object anyway */
+    deserialize(static_cast<const Variant &>(value));
+}
+
+void Serializable::deserialize(const Variant &value)
 {
     if (value.type() != Type::TypeCode::Object)
         throw Exceptions::TypeError(value.toString() + " is not an object");
 
-    const auto &fields = _meta->fields();
+    /* packed records of the same class are copied into fields directly */
+    const Variant::PackedLoader *packed = value.packed();
+    if ((packed != nullptr) && (packed->meta == _meta))
+    {
+        _meta->unpacker()(this, packed->data.data());
+        return;
+    }
+
+    const auto &fields = _meta->fieldList();
     const auto &object = value.internalObject();
 
-    for (const auto &field : object)
-        if (fields.find(field.first) == fields.end())
-            throw Exceptions::ReflectionError("No such field \"" + field.first + "\"");
+    /* one slot per field, in field order */
+    const Variant *stack[StackSlots];
+    std::vector<const Variant *> heap;
+    const Variant **slots = stack;
 
-    for (const auto &field : fields)
+    /* too many fields for the stack */
+    if (fields.size() > StackSlots)
     {
-        if (object.find(field.first) != object.end())
-            field.second->deserialize(this, *object.at(field.first));
+        heap.resize(fields.size());
+        slots = heap.data();
+    }
+
+    /* place every value into it's slot with a single lookup */
+    std::fill_n(slots, fields.size(), nullptr);
+    for (const auto &item : object)
+    {
+        ssize_t index = _meta->indexOf(item.first);
+
+        if (index < 0)
+            throw Exceptions::ReflectionError("No such field \"" + item.first + "\"");
         else
-            throw Exceptions::ReflectionError("Missing field \"" + field.first + "\"");
+            slots[index] = item.second.get();
     }
-}
 
-void Serializable::deserialize(const Variant &value)
-{
-    /* must implement here cause `Variant` is not a complete type in the header */
-    deserialize(Variant(value));
+    /* all fields are required */
+    for (size_t i = 0; i < fields.size(); i++)
+        if (slots[i] == nullptr)
+            throw Exceptions::ReflectionError("Missing field \"" + fields[i]->name() + "\"");
+
+    /* generated deserializer assigns fields directly */
+    if (_meta->deserializer())
+    {
+        _meta->deserializer()(this, slots);
+        return;
+    }
+
+    /* fallback to field thunks */
+    for (size_t i = 0; i < fields.size(); i++)
+        fields[i]->deserialize(this, *slots[i]);
 }
 }
@@ -0,0 +1,450 @@
+/** Flat Serializer / Deserializer Backend
+ *  values carry offset tables, so any item can be read directly from the encoded bytes without parsing
+ **/
+
+#include <vector>
+#include <algorithm>
+
+#include "Variant.h"
+#include "TypeInfo.h"
+#include "Exceptions.h"
+#include "backend/FlatBackend.h"
+
+namespace SimpleRPC
+{
+namespace Backends
+{
+/* nesting limit of decoding, offsets only point forward so malformed data can't loop forever */
+static const size_t MaxDepth = 256;
+
+static inline uint32_t readU32(const uint8_t *p)
+{
+    uint32_t result;
+    memcpy(&result, p, sizeof(uint32_t));
+    return result;
+}
+
+static inline size_t scalarSize(Type::TypeCode type)
+{
+    switch (type)
+    {
+        case Type::TypeCode::Void    : return 0;
+        case Type::TypeCode::Int8    : return sizeof(int8_t  );
+        case Type::TypeCode::Int16   : return sizeof(int16_t );
+        case Type::TypeCode::Int32   : return sizeof(int32_t );
+        case Type::TypeCode::Int64   : return sizeof(int64_t );
+        case Type::TypeCode::UInt8   : return sizeof(uint8_t );
+        case Type::TypeCode::UInt16  : return sizeof(uint16_t);
+        case Type::TypeCode::UInt32  : return sizeof(uint32_t);
+        case Type::TypeCode::UInt64  : return sizeof(uint64_t);
+        case Type::TypeCode::Float   : return sizeof(float   );
+        case Type::TypeCode::Double  : return sizeof(double  );
+        case Type::TypeCode::Boolean : return sizeof(uint8_t );
+
+        /* strings and containers have a 32-bit count after the type code */
+        default                      : return sizeof(uint32_t);
+    }
+}
+
+/****** Random access view ******/
+
+FlatBackend::View::View(const void *data, size_t size) :
+    _p(reinterpret_cast<const uint8_t *>(data)),
+    _end(reinterpret_cast<const uint8_t *>(data) + size)
+{
+    /* type code must be valid */
+    if (!size || (*_p > static_cast<uint8_t>(Type::TypeCode::Object)))
+        throw Exceptions::DeserializerError("Invalid type code");
+
+    /* scalar value, or count of strings and containers */
+    if (size - 1 < scalarSize(type()))
+        throw Exceptions::BufferOverflowError(size - 1);
+
+    /* bytes after the count */
+    size_t n;
+    size -= sizeof(uint32_t) + 1;
+
+    switch (type())
+    {
+        case Type::TypeCode::String:
+        {
+            /* the whole string */
+            if ((n = readU32(_p + 1)) > size)
+                throw Exceptions::BufferOverflowError(size);
+
+            break;
+        }
+
+        case Type::TypeCode::Array:
+        {
+            /* the offset table */
+            if ((n = readU32(_p + 1)) > size / sizeof(uint32_t))
+                throw Exceptions::BufferOverflowError(size);
+
+            break;
+        }
+
+        case Type::TypeCode::Map:
+        case Type::TypeCode::Object:
+        {
+            /* the offset table, keys and values are stored in pairs */
+            if ((n = readU32(_p + 1)) > size / sizeof(uint32_t) / 2)
+                throw Exceptions::BufferOverflowError(size);
+
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+size_t FlatBackend::View::size(void) const
+{
+    switch (type())
+    {
+        case Type::TypeCode::Map:
+        case Type::TypeCode::Array:
+        case Type::TypeCode::Object:
+        case Type::TypeCode::String:
+            return readU32(_p + 1);
+
+        default:
+            throw Exceptions::TypeError("Value has no size");
+    }
+}
+
+size_t FlatBackend::View::offsetOf(size_t index) const
+{
+    /* entries of the offset table, right after the count */
+    return readU32(_p + sizeof(uint32_t) * (index + 1) + 1);
+}
+
+FlatBackend::View FlatBackend::View::item(size_t index) const
+{
+    /* size of header and offset table */
+    size_t n = readU32(_p + 1) * (type() == Type::TypeCode::Array ? 1 : 2);
+    size_t header = (n + 1) * sizeof(uint32_t) + 1;
+    size_t extent = static_cast<size_t>(_end - _p);
+
+    /* items are placed after the offset table in strictly increasing order,
+     * each one ends where the next one starts, and the last one at the end of the container */
+    size_t offset = offsetOf(index);
+    size_t lower = index ? std::max(header, offsetOf(index - 1) + 1) : header;
+    size_t upper = (index + 1 < n) ? offsetOf(index + 1) : extent;
+
+    /* so items never overlap, and decoding can't visit any byte twice */
+    if ((offset < lower) || (offset >= upper) || (upper > extent))
+        throw Exceptions::DeserializerError("Invalid item offset : " + std::to_string(offset));
+
+    return View(_p + offset, upper - offset);
+}
+
+bool FlatBackend::View::locate(const std::string &name, size_t &index) const
+{
+    if (type() != Type::TypeCode::Object)
+        throw Exceptions::TypeError("Value is not an object");
+
+    /* binary search in the field table */
+    size_t lower = 0;
+    size_t upper = size();
+
+    while (lower < upper)
+    {
+        size_t mid = lower + (upper - lower) / 2;
+        View key = item(mid * 2);
+
+        /* field names are strings */
+        if (key.type() != Type::TypeCode::String)
+            throw Exceptions::DeserializerError("Field names of objects must be strings");
+
+        /* compare the name directly in buffer */
+        size_t length = key.size();
+        int result = memcmp(key._p + sizeof(uint32_t) + 1, name.data(), std::min(length, name.size()));
+
+        if (!result && (length == name.size()))
+        {
+            index = mid;
+            return true;
+        }
+
+        if ((result < 0) || (!result && (length < name.size())))
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+
+    return false;
+}
+
+FlatBackend::View FlatBackend::View::operator[](size_t index) const
+{
+    if (type() != Type::TypeCode::Array)
+        throw Exceptions::TypeError("Value is not an array");
+    else if (index >= size())
+        throw Exceptions::IndexError(index);
+    else
+        return item(index);
+}
+
+FlatBackend::View FlatBackend::View::key(size_t index) const
+{
+    if (type() != Type::TypeCode::Map)
+        throw Exceptions::TypeError("Value is not a map");
+    else if (index >= size())
+        throw Exceptions::IndexError(index);
+    else
+        return item(index * 2);
+}
+
+FlatBackend::View FlatBackend::View::value(size_t index) const
+{
+    if (type() != Type::TypeCode::Map)
+        throw Exceptions::TypeError("Value is not a map");
+    else if (index >= size())
+        throw Exceptions::IndexError(index);
+    else
+        return item(index * 2 + 1);
+}
+
+bool FlatBackend::View::hasField(const std::string &name) const
+{
+    size_t index;
+    return locate(name, index);
+}
+
+FlatBackend::View FlatBackend::View::field(const std::string &name) const
+{
+    size_t index;
+
+    if (locate(name, index))
+        return item(index * 2 + 1);
+    else
+        throw Exceptions::NameError(name);
+}
+
+Variant FlatBackend::View::toVariant(size_t depth) const
+{
+    /* check for nesting depth */
+    if (depth > MaxDepth)
+        throw Exceptions::DeserializerError("Nesting depth exceeds limit : " + std::to_string(MaxDepth));
+
+    switch (type())
+    {
+        case Type::TypeCode::Void    : return Variant();
+        case Type::TypeCode::Int8    : return get<int8_t     >();
+        case Type::TypeCode::Int16   : return get<int16_t    >();
+        case Type::TypeCode::Int32   : return get<int32_t    >();
+        case Type::TypeCode::Int64   : return get<int64_t    >();
+        case Type::TypeCode::UInt8   : return get<uint8_t    >();
+        case Type::TypeCode::UInt16  : return get<uint16_t   >();
+        case Type::TypeCode::UInt32  : return get<uint32_t   >();
+        case Type::TypeCode::UInt64  : return get<uint64_t   >();
+        case Type::TypeCode::Float   : return get<float      >();
+        case Type::TypeCode::Double  : return get<double     >();
+        case Type::TypeCode::Boolean : return get<bool       >();
+        case Type::TypeCode::String  : return get<std::string>();
+
+        case Type::TypeCode::Map:
+        {
+            size_t n = size();
+            Variant result(Type::TypeCode::Map);
+
+            /* reserve space to prevent frequent malloc */
+            result.internalMap().reserve(n);
+
+            /* decode every entry */
+            for (size_t i = 0; i < n; i++)
+            {
+                result.internalMap().emplace(
+                    VariantHashKey(item(i * 2).toVariant(depth + 1)),
+                    std::make_shared<Variant>(item(i * 2 + 1).toVariant(depth + 1))
+                );
+            }
+
+            return result;
+        }
+
+        case Type::TypeCode::Array:
+        {
+            size_t n = size();
+            Variant result(Type::TypeCode::Array);
+
+            /* reserve space to prevent frequent malloc */
+            result.internalArray().reserve(n);
+
+            /* decode every item */
+            for (size_t i = 0; i < n; i++)
+                result.internalArray().push_back(std::make_shared<Variant>(item(i).toVariant(depth + 1)));
+
+            return result;
+        }
+
+        case Type::TypeCode::Object:
+        {
+            size_t n = size();
+            Variant result(Type::TypeCode::Object);
+
+            /* decode every field */
+            for (size_t i = 0; i < n; i++)
+            {
+                result.internalObject().emplace(
+                    item(i * 2).get<std::string>(),
+                    std::make_shared<Variant>(item(i * 2 + 1).toVariant(depth + 1))
+                );
+            }
+
+            return result;
+        }
+    }
+
+    /* would NEVER happens */
+    abort();
+}
+
+/****** Serializer ******/
+
+static void writeString(ByteSeq &out, const std::string &value)
+{
+    /* string is too long */
+    if (value.size() > UINT32_MAX)
+        throw Exceptions::SerializerError("String is too long : " + std::to_string(value.size()));
+
+    out.appendLE(static_cast<uint8_t>(Type::TypeCode::String));
+    out.appendLE(static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+static void writeOffset(ByteSeq &out, size_t base, size_t table, size_t slot)
+{
+    /* offset of next item, relative to the container */
+    size_t offset = out.length() - base;
+
+    /* message is too large */
+    if (offset > UINT32_MAX)
+        throw Exceptions::SerializerError("Message is too large : " + std::to_string(offset));
+
+    /* patch into the offset table */
+    uint32_t value = static_cast<uint32_t>(offset);
+    memcpy(out.mutableData() + table + slot * sizeof(uint32_t), &value, sizeof(uint32_t));
+}
+
+static size_t writeHeader(ByteSeq &out, const Variant &value, size_t count, size_t slots)
+{
+    /* container is too large */
+    if (count > UINT32_MAX)
+        throw Exceptions::SerializerError("Container is too large : " + std::to_string(count));
+
+    /* type code and item count */
+    out.appendLE(static_cast<uint8_t>(value.type()));
+    out.appendLE(static_cast<uint32_t>(count));
+
+    /* offset table, will be filled when writing items */
+    size_t table = out.length();
+    memset(out.preserve(slots * sizeof(uint32_t)), 0, slots * sizeof(uint32_t));
+
+    /* commit the offset table */
+    out.commit(slots * sizeof(uint32_t));
+    return table;
+}
+
+static void writeValue(ByteSeq &out, const Variant &value)
+{
+    size_t base = out.length();
+    switch (value.type())
+    {
+        case Type::TypeCode::Void    : out.appendLE(static_cast<uint8_t>(value.type())); break;
+        case Type::TypeCode::String  : writeString(out, value.get<std::string>()); break;
+
+        case Type::TypeCode::Int8    : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<int8_t  >()); break;
+        case Type::TypeCode::Int16   : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<int16_t >()); break;
+        case Type::TypeCode::Int32   : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<int32_t >()); break;
+        case Type::TypeCode::Int64   : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<int64_t >()); break;
+        case Type::TypeCode::UInt8   : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<uint8_t >()); break;
+        case Type::TypeCode::UInt16  : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<uint16_t>()); break;
+        case Type::TypeCode::UInt32  : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<uint32_t>()); break;
+        case Type::TypeCode::UInt64  : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<uint64_t>()); break;
+        case Type::TypeCode::Float   : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<float   >()); break;
+        case Type::TypeCode::Double  : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(value.get<double  >()); break;
+        case Type::TypeCode::Boolean : out.appendLE(static_cast<uint8_t>(value.type())); out.appendLE(static_cast<uint8_t>(value.get<bool>())); break;
+
+        case Type::TypeCode::Map:
+        {
+            const Variant::Map &map = value.internalMap();
+            size_t slot = 0;
+            size_t table = writeHeader(out, value, map.size(), map.size() * 2);
+
+            /* keys and values in pairs */
+            for (const auto &item : map)
+            {
+                writeOffset(out, base, table, slot++);
+                writeValue(out, *item.first.key);
+                writeOffset(out, base, table, slot++);
+                writeValue(out, *item.second);
+            }
+
+            break;
+        }
+
+        case Type::TypeCode::Array:
+        {
+            const Variant::Array &array = value.internalArray();
+            size_t slot = 0;
+            size_t table = writeHeader(out, value, array.size(), array.size());
+
+            /* every item */
+            for (const auto &item : array)
+            {
+                writeOffset(out, base, table, slot++);
+                writeValue(out, *item);
+            }
+
+            break;
+        }
+
+        case Type::TypeCode::Object:
+        {
+            const Variant::Object &object = value.internalObject();
+            std::vector<const Variant::Object::value_type *> fields;
+
+            /* fields are sorted by name for binary search */
+            for (const auto &item : object)
+                fields.push_back(&item);
+
+            /* byte-wise order, the same as `memcmp` */
+            std::sort(fields.begin(), fields.end(), [](auto x, auto y){ return x->first < y->first; });
+
+            /* names and values in pairs */
+            size_t slot = 0;
+            size_t table = writeHeader(out, value, fields.size(), fields.size() * 2);
+
+            for (const auto &item : fields)
+            {
+                writeOffset(out, base, table, slot++);
+                writeString(out, item->first);
+                writeOffset(out, base, table, slot++);
+                writeValue(out, *item->second);
+            }
+
+            break;
+        }
+    }
+}
+
+Variant FlatBackend::parse(ByteSeq &&data) const
+{
+    /* simply decode through view */
+    return View(data).toVariant();
+}
+
+ByteSeq FlatBackend::assemble(Variant &&object) const
+{
+    ByteSeq result;
+    writeValue(result, object);
+    return result;
+}
+
+/* register backend into registry */
+defineAltBackend(FlatBackend)
+}
+}
@@ -0,0 +1,1255 @@
+/** JSON Serializer / Deserializer Backend
+ *  for ``JSON Specification'' please refer to [https://tools.ietf.org/html/rfc8259]
+ **/
+
+#include <cmath>
+#include <limits>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Variant.h"
+#include "TypeInfo.h"
+#include "Exceptions.h"
+#include "backend/JSONBackend.h"
+
+namespace SimpleRPC
+{
+namespace Backends
+{
+/* nesting limit of decoding */
+static const size_t MaxDepth = 256;
+
+/****** Structural scanning ******/
+
+static inline bool isSpecial(uint8_t ch)
+{
+    /* characters that ends a plain run inside strings */
+    return (ch == '"') || (ch == '\\') || (ch < 0x20);
+}
+
+static inline const char *scanString(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x1f);
+
+    /* 16 bytes at a time, control characters are the ones that `min(ch, 0x1f) == ch` */
+    while (end - p >= 16)
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i match = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(value, quote), _mm_cmpeq_epi8(value, slash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(value, space), value)
+        );
+
+        /* position of the first special character */
+        int mask = _mm_movemask_epi8(match);
+        if (mask)
+            return p + __builtin_ctz(mask);
+
+        p += 16;
+    }
+#endif
+
+    /* the remaining bytes */
+    while ((p < end) && !isSpecial(static_cast<uint8_t>(*p)))
+        p++;
+
+    return p;
+}
+
+static inline bool isDigit(char ch)
+{
+    return (ch >= '0') && (ch <= '9');
+}
+
+static inline const char *skipDigits(const char *p, const char *end)
+{
+    while ((p < end) && isDigit(*p))
+        p++;
+
+    return p;
+}
+
+static inline const char *skipSpaces(const char *p, const char *end)
+{
+    while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r')))
+        p++;
+
+    return p;
+}
+
+/****** Number formatting ******/
+
+static inline void appendUnsigned(ByteSeq &out, uint64_t value)
+{
+    char buffer[24];
+    char *p = buffer + sizeof(buffer);
+
+    /* digits from the lowest one */
+    do *--p = static_cast<char>('0' + value % 10);
+    while (value /= 10);
+
+    out.append(p, buffer + sizeof(buffer) - p);
+}
+
+static inline void appendSigned(ByteSeq &out, int64_t value)
+{
+    if (value >= 0)
+    {
+        appendUnsigned(out, static_cast<uint64_t>(value));
+    }
+    else
+    {
+        out.append("-", 1);
+        appendUnsigned(out, ~static_cast<uint64_t>(value) + 1);
+    }
+}
+
+/****** Real numbers ******/
+
+template <typename T>
+struct RealTraits;
+
+template <>
+struct RealTraits<float>
+{
+    typedef uint32_t Bits;
+
+    static const int Bias = 150;
+    static const int Mantissa = 23;
+
+    /* largest integers and powers of 10 that are exact in `float` */
+    static const int MaxPower = 10;
+    static const uint64_t MaxSignificand = 1ull << 24;
+
+public:
+    static float power(int exponent)
+    {
+        static const float powers[] = {
+            1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+        };
+
+        return powers[exponent];
+    }
+
+public:
+    static float parse(const char *text) { return strtof(text, nullptr); }
+};
+
+template <>
+struct RealTraits<double>
+{
+    typedef uint64_t Bits;
+
+    static const int Bias = 1075;
+    static const int Mantissa = 52;
+
+    /* largest integers and powers of 10 that are exact in `double` */
+    static const int MaxPower = 22;
+    static const uint64_t MaxSignificand = 1ull << 53;
+
+public:
+    static double power(int exponent)
+    {
+        static const double powers[] = {
+            1e0 , 1e1 , 1e2 , 1e3 , 1e4 , 1e5 , 1e6 , 1e7 , 1e8 , 1e9 , 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+        };
+
+        return powers[exponent];
+    }
+
+public:
+    static double parse(const char *text) { return strtod(text, nullptr); }
+};
+
+/****** Real number formatting ******/
+
+/* shortest round-trip digits with `Grisu3` from "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers" (Loitsch, 2010), which gives up on about 0.5% of the values and leaves them to `snprintf` */
+
+struct DiyFp
+{
+    uint64_t f;
+    int      e;
+};
+
+struct CachedPower
+{
+    uint64_t f;
+    int16_t  e;
+    int16_t  k;
+};
+
+/* normalized 10^k for every 8th k from -348 to 340 */
+static const CachedPower CachedPowers[] = {
+    { 0xfa8fd5a0081c0288ull, -1220, -348 },
+    { 0xbaaee17fa23ebf76ull, -1193, -340 },
+    { 0x8b16fb203055ac76ull, -1166, -332 },
+    { 0xcf42894a5dce35eaull, -1140, -324 },
+    { 0x9a6bb0aa55653b2dull, -1113, -316 },
+    { 0xe61acf033d1a45dfull, -1087, -308 },
+    { 0xab70fe17c79ac6caull, -1060, -300 },
+    { 0xff77b1fcbebcdc4full, -1034, -292 },
+    { 0xbe5691ef416bd60cull, -1007, -284 },
+    { 0x8dd01fad907ffc3cull,  -980, -276 },
+    { 0xd3515c2831559a83ull,  -954, -268 },
+    { 0x9d71ac8fada6c9b5ull,  -927, -260 },
+    { 0xea9c227723ee8bcbull,  -901, -252 },
+    { 0xaecc49914078536dull,  -874, -244 },
+    { 0x823c12795db6ce57ull,  -847, -236 },
+    { 0xc21094364dfb5637ull,  -821, -228 },
+    { 0x9096ea6f3848984full,  -794, -220 },
+    { 0xd77485cb25823ac7ull,  -768, -212 },
+    { 0xa086cfcd97bf97f4ull,  -741, -204 },
+    { 0xef340a98172aace5ull,  -715, -196 },
+    { 0xb23867fb2a35b28eull,  -688, -188 },
+    { 0x84c8d4dfd2c63f3bull,  -661, -180 },
+    { 0xc5dd44271ad3cdbaull,  -635, -172 },
+    { 0x936b9fcebb25c996ull,  -608, -164 },
+    { 0xdbac6c247d62a584ull,  -582, -156 },
+    { 0xa3ab66580d5fdaf6ull,  -555, -148 },
+    { 0xf3e2f893dec3f126ull,  -529, -140 },
+    { 0xb5b5ada8aaff80b8ull,  -502, -132 },
+    { 0x87625f056c7c4a8bull,  -475, -124 },
+    { 0xc9bcff6034c13053ull,  -449, -116 },
+    { 0x964e858c91ba2655ull,  -422, -108 },
+    { 0xdff9772470297ebdull,  -396, -100 },
+    { 0xa6dfbd9fb8e5b88full,  -369,  -92 },
+    { 0xf8a95fcf88747d94ull,  -343,  -84 },
+    { 0xb94470938fa89bcfull,  -316,  -76 },
+    { 0x8a08f0f8bf0f156bull,  -289,  -68 },
+    { 0xcdb02555653131b6ull,  -263,  -60 },
+    { 0x993fe2c6d07b7facull,  -236,  -52 },
+    { 0xe45c10c42a2b3b06ull,  -210,  -44 },
+    { 0xaa242499697392d3ull,  -183,  -36 },
+    { 0xfd87b5f28300ca0eull,  -157,  -28 },
+    { 0xbce5086492111aebull,  -130,  -20 },
+    { 0x8cbccc096f5088ccull,  -103,  -12 },
+    { 0xd1b71758e219652cull,   -77,   -4 },
+    { 0x9c40000000000000ull,   -50,    4 },
+    { 0xe8d4a51000000000ull,   -24,   12 },
+    { 0xad78ebc5ac620000ull,     3,   20 },
+    { 0x813f3978f8940984ull,    30,   28 },
+    { 0xc097ce7bc90715b3ull,    56,   36 },
+    { 0x8f7e32ce7bea5c70ull,    83,   44 },
+    { 0xd5d238a4abe98068ull,   109,   52 },
+    { 0x9f4f2726179a2245ull,   136,   60 },
+    { 0xed63a231d4c4fb27ull,   162,   68 },
+    { 0xb0de65388cc8ada8ull,   189,   76 },
+    { 0x83c7088e1aab65dbull,   216,   84 },
+    { 0xc45d1df942711d9aull,   242,   92 },
+    { 0x924d692ca61be758ull,   269,  100 },
+    { 0xda01ee641a708deaull,   295,  108 },
+    { 0xa26da3999aef774aull,   322,  116 },
+    { 0xf209787bb47d6b85ull,   348,  124 },
+    { 0xb454e4a179dd1877ull,   375,  132 },
+    { 0x865b86925b9bc5c2ull,   402,  140 },
+    { 0xc83553c5c8965d3dull,   428,  148 },
+    { 0x952ab45cfa97a0b3ull,   455,  156 },
+    { 0xde469fbd99a05fe3ull,   481,  164 },
+    { 0xa59bc234db398c25ull,   508,  172 },
+    { 0xf6c69a72a3989f5cull,   534,  180 },
+    { 0xb7dcbf5354e9beceull,   561,  188 },
+    { 0x88fcf317f22241e2ull,   588,  196 },
+    { 0xcc20ce9bd35c78a5ull,   614,  204 },
+    { 0x98165af37b2153dfull,   641,  212 },
+    { 0xe2a0b5dc971f303aull,   667,  220 },
+    { 0xa8d9d1535ce3b396ull,   694,  228 },
+    { 0xfb9b7cd9a4a7443cull,   720,  236 },
+    { 0xbb764c4ca7a44410ull,   747,  244 },
+    { 0x8bab8eefb6409c1aull,   774,  252 },
+    { 0xd01fef10a657842cull,   800,  260 },
+    { 0x9b10a4e5e9913129ull,   827,  268 },
+    { 0xe7109bfba19c0c9dull,   853,  276 },
+    { 0xac2820d9623bf429ull,   880,  284 },
+    { 0x80444b5e7aa7cf85ull,   907,  292 },
+    { 0xbf21e44003acdd2dull,   933,  300 },
+    { 0x8e679c2f5e44ff8full,   960,  308 },
+    { 0xd433179d9c8cb841ull,   986,  316 },
+    { 0x9e19db92b4e31ba9ull,  1013,  324 },
+    { 0xeb96bf6ebadf77d9ull,  1039,  332 },
+    { 0xaf87023b9bf0ee6bull,  1066,  340 },
+};
+
+static inline DiyFp normalize(DiyFp x)
+{
+    int shift = __builtin_clzll(x.f);
+    return { x.f << shift, x.e - shift };
+}
+
+static inline DiyFp multiply(DiyFp x, DiyFp y)
+{
+    /* upper 64 bits of the 128-bit product, rounded */
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & 0xffffffffu;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & 0xffffffffu;
+    uint64_t t = (b * d >> 32) + (a * d & 0xffffffffu) + (b * c & 0xffffffffu) + (1u << 31);
+
+    return { a * c + (a * d >> 32) + (b * c >> 32) + (t >> 32), x.e + y.e + 64 };
+}
+
+static inline DiyFp cachedPower(int e, int &k)
+{
+    /* 10^k that brings a normalized `2^e` into [2^-60, 2^-32) */
+    int n = static_cast<int>(ceil((-61 - e) * 0.30102999566398114));
+    const CachedPower &power = CachedPowers[(n + 347) / 8 + 1];
+
+    k = power.k;
+    return { power.f, power.e };
+}
+
+static bool roundWeed(char *digits, int length, uint64_t distance, uint64_t unsafe, uint64_t rest, uint64_t ten, uint64_t unit)
+{
+    uint64_t small = distance - unit;
+    uint64_t big = distance + unit;
+
+    /* move the last digit towards the exact value while it stays inside the unsafe interval */
+    while ((rest < small) && (unsafe - rest >= ten) && ((rest + ten < small) || (small - rest >= rest + ten - small)))
+    {
+        digits[length - 1]--;
+        rest += ten;
+    }
+
+    /* can't tell which one is closer */
+    if ((rest < big) && (unsafe - rest >= ten) && ((rest + ten < big) || (big - rest > rest + ten - big)))
+        return false;
+
+    /* must be safely inside the rounding interval */
+    return (2 * unit <= rest) && (rest <= unsafe - 4 * unit);
+}
+
+static bool digitGen(DiyFp low, DiyFp w, DiyFp high, char *digits, int &length, int &kappa)
+{
+    /* widen the boundaries by the multiplication error */
+    uint64_t unit = 1;
+    uint64_t tooLow = low.f - unit;
+    uint64_t tooHigh = high.f + unit;
+    uint64_t unsafe = tooHigh - tooLow;
+
+    /* split into integral and fractional parts */
+    int shift = -w.e;
+    uint64_t one = 1ull << shift;
+    uint32_t integrals = static_cast<uint32_t>(tooHigh >> shift);
+    uint64_t fractionals = tooHigh & (one - 1);
+
+    /* largest power of 10 in the integral part */
+    uint32_t divisor = 1000000000;
+    for (kappa = 10; divisor > integrals; kappa--)
+        divisor /= 10;
+
+    /* integral digits */
+    for (length = 0; kappa > 0; divisor /= 10)
+    {
+        digits[length++] = static_cast<char>('0' + integrals / divisor);
+        integrals %= divisor;
+        kappa--;
+
+        /* enough digits to identify the value */
+        uint64_t rest = (static_cast<uint64_t>(integrals) << shift) + fractionals;
+        if (rest < unsafe)
+            return roundWeed(digits, length, tooHigh - w.f, unsafe, rest, static_cast<uint64_t>(divisor) << shift, unit);
+    }
+
+    /* fractional digits, the error grows along with them */
+    for (;;)
+    {
+        unit *= 10;
+        unsafe *= 10;
+        fractionals *= 10;
+        digits[length++] = static_cast<char>('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        kappa--;
+
+        /* enough digits to identify the value */
+        if (fractionals < unsafe)
+            return roundWeed(digits, length, (tooHigh - w.f) * unit, unsafe, fractionals, one, unit);
+    }
+}
+
+template <typename T>
+static bool grisu3(T value, char *digits, int &length, int &exponent)
+{
+    typedef RealTraits<T> Traits;
+    typename Traits::Bits bits;
+
+    /* decompose positive values into `f * 2^e`, subnormals have no hidden bit */
+    memcpy(&bits, &value, sizeof(bits));
+    int field = static_cast<int>(bits >> Traits::Mantissa);
+    uint64_t hidden = 1ull << Traits::Mantissa;
+    uint64_t f = bits & (hidden - 1);
+    int e = 1 - Traits::Bias;
+
+    if (field)
+    {
+        f |= hidden;
+        e = field - Traits::Bias;
+    }
+
+    /* boundaries are half way to the neighbours, the lower one is closer on powers of 2 */
+    DiyFp w = normalize({ f, e });
+    DiyFp plus = normalize({ (f << 1) + 1, e - 1 });
+    DiyFp minus = ((f == hidden) && (field > 1)) ? DiyFp { (f << 2) - 1, e - 2 } : DiyFp { (f << 1) - 1, e - 1 };
+
+    /* with the same exponent */
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    /* scale into the range where digits can be generated with 64-bit integers */
+    int k;
+    DiyFp power = cachedPower(w.e, k);
+
+    /* `digits * 10^exponent` */
+    if (!digitGen(multiply(minus, power), multiply(w, power), multiply(plus, power), digits, length, exponent))
+        return false;
+
+    exponent -= k;
+    return true;
+}
+
+template <typename T>
+static void shortest(T value, char *digits, int &length, int &exponent)
+{
+    char buffer[32];
+
+    /* fewest `%e` digits that parse back to the same value */
+    for (int precision = 0; ; precision++)
+    {
+        snprintf(buffer, sizeof(buffer), "%.*e", precision, static_cast<double>(value));
+
+        if (RealTraits<T>::parse(buffer) == value)
+            break;
+    }
+
+    /* "d.ddde[+-]xx" */
+    const char *p = buffer;
+    for (length = 0; *p != 'e'; p++)
+        if (*p != '.')
+            digits[length++] = *p;
+
+    /* `digits * 10^exponent` */
+    exponent = atoi(p + 1) - length + 1;
+    while ((length > 1) && (digits[length - 1] == '0'))
+    {
+        length--;
+        exponent++;
+    }
+}
+
+template <typename T>
+static void appendReal(ByteSeq &out, T value)
+{
+    char buffer[48];
+    char *p = buffer;
+
+    /* sign goes first, including negative zeros */
+    if (std::signbit(value))
+    {
+        *p++ = '-';
+        value = -value;
+    }
+
+    /* digits can't be generated for zeros */
+    if (value == 0)
+    {
+        memcpy(p, "0.0", 3);
+        out.append(buffer, p - buffer + 3);
+        return;
+    }
+
+    /* shortest digits that round-trip, `Grisu3` first */
+    int length;
+    int exponent;
+    char digits[32];
+
+    if (!grisu3(value, digits, length, exponent))
+        shortest(value, digits, length, exponent);
+
+    /* position of the decimal point */
+    int point = length + exponent;
+
+    /* plain notation like `%g` does, always with a decimal point to keep it distinguishable from integers */
+    if ((point > -4) && (point <= 17))
+    {
+        if (point <= 0)
+        {
+            memcpy(p, "0.", 2);
+            memset(p + 2, '0', -point);
+            memcpy(p + 2 - point, digits, length);
+            p += 2 - point + length;
+        }
+        else if (point >= length)
+        {
+            memcpy(p, digits, length);
+            memset(p + length, '0', point - length);
+            memcpy(p + point, ".0", 2);
+            p += point + 2;
+        }
+        else
+        {
+            memcpy(p, digits, point);
+            p[point] = '.';
+            memcpy(p + point + 1, digits + point, length - point);
+            p += length + 1;
+        }
+    }
+    else
+    {
+        /* scientific notation */
+        *p++ = digits[0];
+
+        if (length > 1)
+        {
+            *p++ = '.';
+            memcpy(p, digits + 1, length - 1);
+            p += length - 1;
+        }
+
+        /* exponent of the first digit */
+        int power = point - 1;
+        *p++ = 'e';
+
+        if (power < 0)
+        {
+            *p++ = '-';
+            power = -power;
+        }
+
+        if (power >= 100) *p++ = static_cast<char>('0' + power / 100);
+        if (power >= 10 ) *p++ = static_cast<char>('0' + power / 10 % 10);
+        *p++ = static_cast<char>('0' + power % 10);
+    }
+
+    out.append(buffer, p - buffer);
+}
+
+template <typename T>
+static void appendAnnotatedReal(ByteSeq &out, const char *annotation, T value)
+{
+    out.append(annotation);
+
+    /* JSON has no representations for these */
+    if (std::isnan(value))
+        out.append("\"NaN\"}");
+    else if (std::isinf(value))
+        out.append(value > 0 ? "\"Infinity\"}" : "\"-Infinity\"}");
+    else
+    {
+        appendReal(out, value);
+        out.append("}", 1);
+    }
+}
+
+/****** Serializer ******/
+
+static void writeString(ByteSeq &out, const std::string &value)
+{
+    const char *p = value.data();
+    const char *end = p + value.size();
+
+    /* copy plain runs in bulk, and escape the special characters between them */
+    out.append("\"", 1);
+    while (p < end)
+    {
+        const char *next = scanString(p, end);
+        out.append(p, next - p);
+
+        /* end of string */
+        if ((p = next) == end)
+            break;
+
+        switch (*p)
+        {
+            case '"'  : out.append("\\\"", 2); break;
+            case '\\' : out.append("\\\\", 2); break;
+            case '\b' : out.append("\\b" , 2); break;
+            case '\f' : out.append("\\f" , 2); break;
+            case '\n' : out.append("\\n" , 2); break;
+            case '\r' : out.append("\\r" , 2); break;
+            case '\t' : out.append("\\t" , 2); break;
+
+            default:
+            {
+                char escape[7];
+                snprintf(escape, sizeof(escape), "\\u%04x", static_cast<uint8_t>(*p));
+                out.append(escape, 6);
+                break;
+            }
+        }
+
+        p++;
+    }
+
+    out.append("\"", 1);
+}
+
+static void writeValue(ByteSeq &out, const Variant &value)
+{
+    switch (value.type())
+    {
+        case Type::TypeCode::Void    : out.append("null", 4); break;
+        case Type::TypeCode::Boolean : value.get<bool>() ? out.append("true", 4) : out.append("false", 5); break;
+        case Type::TypeCode::String  : writeString(out, value.get<std::string>()); break;
+
+        /* the most common integer type is not annotated */
+        case Type::TypeCode::Int32   : appendSigned(out, value.get<int32_t>()); break;
+
+        /* other integers are annotated with widths */
+        case Type::TypeCode::Int8    : out.append("{\"$i8\":" ); appendSigned  (out, value.get<int8_t  >()); out.append("}", 1); break;
+        case Type::TypeCode::Int16   : out.append("{\"$i16\":"); appendSigned  (out, value.get<int16_t >()); out.append("}", 1); break;
+        case Type::TypeCode::Int64   : out.append("{\"$i64\":"); appendSigned  (out, value.get<int64_t >()); out.append("}", 1); break;
+        case Type::TypeCode::UInt8   : out.append("{\"$u8\":" ); appendUnsigned(out, value.get<uint8_t >()); out.append("}", 1); break;
+        case Type::TypeCode::UInt16  : out.append("{\"$u16\":"); appendUnsigned(out, value.get<uint16_t>()); out.append("}", 1); break;
+        case Type::TypeCode::UInt32  : out.append("{\"$u32\":"); appendUnsigned(out, value.get<uint32_t>()); out.append("}", 1); break;
+        case Type::TypeCode::UInt64  : out.append("{\"$u64\":"); appendUnsigned(out, value.get<uint64_t>()); out.append("}", 1); break;
+
+        /* single precision numbers are always annotated */
+        case Type::TypeCode::Float:
+        {
+            appendAnnotatedReal(out, "{\"$f32\":", value.get<float>());
+            break;
+        }
+
+        /* double precision numbers are annotated only when not finite */
+        case Type::TypeCode::Double:
+        {
+            if (std::isfinite(value.get<double>()))
+                appendReal(out, value.get<double>());
+            else
+                appendAnnotatedReal(out, "{\"$f64\":", value.get<double>());
+
+            break;
+        }
+
+        case Type::TypeCode::Map:
+        {
+            bool first = true;
+            out.append("{\"$map\":[");
+
+            /* key-value pairs */
+            for (const auto &item : value.internalMap())
+            {
+                out.append(first ? "[" : ",[", first ? 1 : 2);
+                writeValue(out, *item.first.key);
+                out.append(",", 1);
+                writeValue(out, *item.second);
+                out.append("]", 1);
+                first = false;
+            }
+
+            out.append("]}", 2);
+            break;
+        }
+
+        case Type::TypeCode::Array:
+        {
+            bool first = true;
+            out.append("[", 1);
+
+            /* every item */
+            for (const auto &item : value.internalArray())
+            {
+                if (!first)
+                    out.append(",", 1);
+
+                first = false;
+                writeValue(out, *item);
+            }
+
+            out.append("]", 1);
+            break;
+        }
+
+        case Type::TypeCode::Object:
+        {
+            bool first = true;
+            out.append("{", 1);
+
+            /* every field */
+            for (const auto &item : value.internalObject())
+            {
+                if (!first)
+                    out.append(",", 1);
+
+                first = false;
+                writeString(out, item.first);
+                out.append(":", 1);
+                writeValue(out, *item.second);
+            }
+
+            out.append("}", 1);
+            break;
+        }
+    }
+}
+
+/****** Deserializer ******/
+
+struct JSONReader
+{
+    const char *p;
+    const char *end;
+    const char *begin;
+
+public:
+    explicit JSONReader(const char *data, size_t size) : p(data), end(data + size), begin(data) {}
+
+public:
+    [[noreturn]] void fail(const std::string &message) const
+    {
+        throw Exceptions::DeserializerError("Invalid JSON at offset " + std::to_string(p - begin) + " : " + message);
+    }
+
+public:
+    char peek(void)
+    {
+        /* skip whitespaces before tokens */
+        if ((p = skipSpaces(p, end)) == end)
+            fail("unexpected end of data");
+
+        return *p;
+    }
+
+public:
+    void expect(char ch)
+    {
+        if (peek() != ch)
+            fail(std::string("expected '") + ch + "'");
+
+        p++;
+    }
+
+public:
+    void literal(const char *text, size_t size)
+    {
+        if ((static_cast<size_t>(end - p) < size) || memcmp(p, text, size))
+            fail("invalid literal");
+
+        p += size;
+    }
+
+public:
+    uint32_t hex4(void)
+    {
+        uint32_t result = 0;
+
+        /* exactly 4 hex digits */
+        if (end - p < 4)
+            fail("incomplete unicode escape");
+
+        for (int i = 0; i < 4; i++)
+        {
+            char ch = *p++;
+            result <<= 4;
+
+            if (ch >= '0' && ch <= '9')
+                result |= ch - '0';
+            else if (ch >= 'a' && ch <= 'f')
+                result |= ch - 'a' + 10;
+            else if (ch >= 'A' && ch <= 'F')
+                result |= ch - 'A' + 10;
+            else
+                fail("invalid unicode escape");
+        }
+
+        return result;
+    }
+
+public:
+    std::string string(void)
+    {
+        std::string result;
+        expect('"');
+
+        for (;;)
+        {
+            /* copy plain runs in bulk */
+            const char *next = scanString(p, end);
+            result.append(p, next - p);
+
+            /* string must be closed */
+            if ((p = next) == end)
+                fail("unterminated string");
+
+            /* end of string */
+            if (*p == '"')
+            {
+                p++;
+                return result;
+            }
+
+            /* control characters must be escaped */
+            if (*p != '\\')
+                fail("unescaped control character");
+
+            /* escape sequences */
+            if (++p == end)
+                fail("unterminated string");
+
+            switch (*p++)
+            {
+                case '"'  : result += '"' ; break;
+                case '\\' : result += '\\'; break;
+                case '/'  : result += '/' ; break;
+                case 'b'  : result += '\b'; break;
+                case 'f'  : result += '\f'; break;
+                case 'n'  : result += '\n'; break;
+                case 'r'  : result += '\r'; break;
+                case 't'  : result += '\t'; break;
+
+                case 'u':
+                {
+                    uint32_t code = hex4();
+
+                    /* surrogate pairs */
+                    if ((code >= 0xd800) && (code <= 0xdbff))
+                    {
+                        literal("\\u", 2);
+                        uint32_t low = hex4();
+
+                        if ((low < 0xdc00) || (low > 0xdfff))
+                            fail("invalid surrogate pair");
+
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+
+                    /* encode as UTF-8 */
+                    if (code < 0x80)
+                    {
+                        result += static_cast<char>(code);
+                    }
+                    else if (code < 0x800)
+                    {
+                        result += static_cast<char>(0xc0 | (code >> 6));
+                        result += static_cast<char>(0x80 | (code & 0x3f));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        result += static_cast<char>(0xe0 | (code >> 12));
+                        result += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                        result += static_cast<char>(0x80 | (code & 0x3f));
+                    }
+                    else
+                    {
+                        result += static_cast<char>(0xf0 | (code >> 18));
+                        result += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+                        result += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                        result += static_cast<char>(0x80 | (code & 0x3f));
+                    }
+
+                    break;
+                }
+
+                default:
+                    fail("invalid escape sequence");
+            }
+        }
+    }
+
+public:
+    /* number token, returns whether it's an integer */
+    bool number(const char *&start, size_t &size)
+    {
+        bool integer = true;
+        start = p;
+
+        /* optional minus sign */
+        if ((p < end) && (*p == '-'))
+            p++;
+
+        /* integer part, zero or digits without leading zeros */
+        if ((p < end) && (*p == '0'))
+        {
+            if ((++p < end) && isDigit(*p))
+                fail("leading zeros are not allowed");
+        }
+        else
+        {
+            if ((p == end) || !isDigit(*p))
+                fail("invalid number");
+
+            p = skipDigits(p, end);
+        }
+
+        /* optional fraction part */
+        if ((p < end) && (*p == '.'))
+        {
+            if ((++p == end) || !isDigit(*p))
+                fail("invalid fraction");
+
+            integer = false;
+            p = skipDigits(p, end);
+        }
+
+        /* optional exponent part */
+        if ((p < end) && ((*p == 'e') || (*p == 'E')))
+        {
+            if ((++p < end) && ((*p == '+') || (*p == '-')))
+                p++;
+
+            if ((p == end) || !isDigit(*p))
+                fail("invalid exponent");
+
+            integer = false;
+            p = skipDigits(p, end);
+        }
+
+        size = p - start;
+        return integer;
+    }
+
+public:
+    bool integer(const char *start, size_t size, bool &negative, uint64_t &value)
+    {
+        value = 0;
+        negative = (*start == '-');
+
+        /* accumulate digits with overflow check */
+        for (const char *q = start + negative; q < start + size; q++)
+        {
+            uint64_t digit = static_cast<uint64_t>(*q - '0');
+
+            if (value > (UINT64_MAX - digit) / 10)
+                return false;
+
+            value = value * 10 + digit;
+        }
+
+        return true;
+    }
+
+public:
+    template <typename T>
+    T real(const char *start, size_t size)
+    {
+        int digits = 0;
+        int exponent = 0;
+        uint64_t significand = 0;
+        const char *q = start + (*start == '-');
+        const char *stop = start + size;
+
+        /* significant digits, tokens are well-formed already */
+        for (bool fraction = false; (q < stop) && (*q != 'e') && (*q != 'E'); q++)
+        {
+            if (*q == '.')
+            {
+                fraction = true;
+                continue;
+            }
+
+            /* leading zeros are not significant, and at most 19 digits fit in 64 bits */
+            if ((significand || (*q != '0')) && (++digits > 19))
+                return RealTraits<T>::parse(std::string(start, size).c_str());
+
+            exponent -= fraction;
+            significand = significand * 10 + static_cast<uint64_t>(*q - '0');
+        }
+
+        /* explicit exponent, large ones are left to `strtod` anyway */
+        if (q < stop)
+        {
+            int power = 0;
+            bool negative = (*++q == '-');
+
+            for (q += (*q == '+') || (*q == '-'); (q < stop) && (power < 10000); q++)
+                power = power * 10 + (*q - '0');
+
+            exponent += negative ? -power : power;
+        }
+
+        /* Clinger's fast path, both operands are exact so the result is correctly rounded */
+        if ((significand <= RealTraits<T>::MaxSignificand) && (exponent >= -RealTraits<T>::MaxPower) && (exponent <= RealTraits<T>::MaxPower))
+        {
+            T result = static_cast<T>(significand);
+            result = (exponent < 0) ? result / RealTraits<T>::power(-exponent) : result * RealTraits<T>::power(exponent);
+            return (*start == '-') ? -result : result;
+        }
+
+        /* `strtod` requires null-terminated strings */
+        return RealTraits<T>::parse(std::string(start, size).c_str());
+    }
+
+public:
+    Variant plainNumber(void)
+    {
+        size_t size;
+        const char *start;
+
+        /* real numbers */
+        if (!number(start, size))
+            return real<double>(start, size);
+
+        /* integers, in the smallest type that can hold them */
+        bool negative;
+        uint64_t value;
+
+        if (!integer(start, size, negative, value))
+            return real<double>(start, size);
+
+        if (!negative)
+        {
+            if (value <= INT32_MAX)
+                return static_cast<int32_t>(value);
+            else if (value <= INT64_MAX)
+                return static_cast<int64_t>(value);
+            else
+                return value;
+        }
+        else
+        {
+            if (value <= static_cast<uint64_t>(INT32_MAX) + 1)
+                return static_cast<int32_t>(-static_cast<int64_t>(value));
+            else if (value <= static_cast<uint64_t>(INT64_MAX) + 1)
+                return static_cast<int64_t>(~value + 1);
+            else
+                return real<double>(start, size);
+        }
+    }
+
+public:
+    template <typename T>
+    T annotatedInteger(void)
+    {
+        size_t size;
+        bool negative;
+        uint64_t value;
+        const char *start;
+
+        /* must be an integer */
+        peek();
+        if (!number(start, size) || !integer(start, size, negative, value))
+            fail("invalid integer");
+
+        /* check for range */
+        if (negative)
+        {
+            if (std::is_unsigned<T>::value || (value > static_cast<uint64_t>(std::numeric_limits<T>::max()) + 1))
+                fail("integer out of range");
+
+            return static_cast<T>(~value + 1);
+        }
+        else
+        {
+            if (value > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+                fail("integer out of range");
+
+            return static_cast<T>(value);
+        }
+    }
+
+public:
+    template <typename T>
+    T annotatedReal(void)
+    {
+        /* non-finite numbers are strings */
+        if (peek() == '"')
+        {
+            std::string text = string();
+
+            if (text == "NaN")
+                return std::numeric_limits<T>::quiet_NaN();
+            else if (text == "Infinity")
+                return std::numeric_limits<T>::infinity();
+            else if (text == "-Infinity")
+                return -std::numeric_limits<T>::infinity();
+            else
+                fail("invalid real number");
+        }
+
+        /* finite numbers */
+        size_t size;
+        const char *start;
+
+        number(start, size);
+        return real<T>(start, size);
+    }
+
+public:
+    static bool isAnnotation(const std::string &name)
+    {
+        /* only the keys emitted by `assemble`, other `$` prefixed keys are ordinary fields */
+        static const char *const annotations[] = {
+            "$i8", "$i16", "$i32", "$i64", "$u8", "$u16", "$u32", "$u64", "$f32", "$f64", "$map",
+        };
+
+        for (const char *annotation : annotations)
+            if (name == annotation)
+                return true;
+
+        return false;
+    }
+
+public:
+    Variant annotated(const std::string &annotation, size_t depth)
+    {
+        if (annotation == "$i8" ) return annotatedInteger<int8_t  >();
+        if (annotation == "$i16") return annotatedInteger<int16_t >();
+        if (annotation == "$i32") return annotatedInteger<int32_t >();
+        if (annotation == "$i64") return annotatedInteger<int64_t >();
+        if (annotation == "$u8" ) return annotatedInteger<uint8_t >();
+        if (annotation == "$u16") return annotatedInteger<uint16_t>();
+        if (annotation == "$u32") return annotatedInteger<uint32_t>();
+        if (annotation == "$u64") return annotatedInteger<uint64_t>();
+        if (annotation == "$f32") return annotatedReal<float >();
+        if (annotation == "$f64") return annotatedReal<double>();
+
+        /* only maps are left */
+        /* maps are arrays of key-value pairs */
+        Variant result(Type::TypeCode::Map);
+        expect('[');
+
+        /* empty map */
+        if (peek() == ']')
+        {
+            p++;
+            return result;
+        }
+
+        for (;;)
+        {
+            expect('[');
+            Variant key = value(depth + 1);
+            expect(',');
+            Variant item = value(depth + 1);
+            expect(']');
+
+            /* add to map */
+            result.internalMap().emplace(
+                VariantHashKey(std::move(key)),
+                std::make_shared<Variant>(std::move(item))
+            );
+
+            /* more pairs */
+            if (peek() == ']')
+            {
+                p++;
+                return result;
+            }
+
+            expect(',');
+        }
+    }
+
+public:
+    Variant value(size_t depth)
+    {
+        /* check for nesting depth */
+        if (depth > MaxDepth)
+            fail("nesting depth exceeds limit " + std::to_string(MaxDepth));
+
+        switch (peek())
+        {
+            case 'n' : literal("null" , 4); return Variant();
+            case 't' : literal("true" , 4); return true;
+            case 'f' : literal("false", 5); return false;
+            case '"' : return string();
+
+            case '-':
+            case '0' ... '9':
+                return plainNumber();
+
+            case '[':
+            {
+                Variant result(Type::TypeCode::Array);
+                p++;
+
+                /* empty array */
+                if (peek() == ']')
+                {
+                    p++;
+                    return result;
+                }
+
+                for (;;)
+                {
+                    /* every item */
+                    result.internalArray().push_back(std::make_shared<Variant>(value(depth + 1)));
+
+                    /* more items */
+                    if (peek() == ']')
+                    {
+                        p++;
+                        return result;
+                    }
+
+                    expect(',');
+                }
+            }
+
+            case '{':
+            {
+                Variant result(Type::TypeCode::Object);
+                p++;
+
+                /* empty object */
+                if (peek() == '}')
+                {
+                    p++;
+                    return result;
+                }
+
+                for (bool first = true;; first = false)
+                {
+                    std::string name = string();
+                    expect(':');
+
+                    /* annotated values are objects with a single annotation key */
+                    if (first && isAnnotation(name))
+                    {
+                        Variant annotation = annotated(name, depth);
+                        expect('}');
+                        return annotation;
+                    }
+
+                    /* every field */
+                    result.internalObject().emplace(std::move(name), std::make_shared<Variant>(value(depth + 1)));
+
+                    /* more fields */
+                    if (peek() == '}')
+                    {
+                        p++;
+                        return result;
+                    }
+
+                    expect(',');
+                }
+            }
+
+            default:
+                fail(std::string("unexpected character '") + *p + "'");
+        }
+    }
+};
+
+Variant JSONBackend::parse(ByteSeq &&data) const
+{
+    JSONReader reader(data.data(), data.length());
+    Variant result = reader.value(0);
+
+    /* only whitespaces are allowed after the value */
+    if (skipSpaces(reader.p, reader.end) != reader.end)
+        reader.fail("trailing characters");
+
+    return result;
+}
+
+ByteSeq JSONBackend::assemble(Variant &&object) const
+{
+    ByteSeq result;
+    writeValue(result, object);
+    return result;
+}
+
+/* register backend into registry */
+defineAltBackend(JSONBackend)
+}
+}
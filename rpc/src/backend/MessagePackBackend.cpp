@@ -2,7 +2,12 @@
  *  for ``MessagePack Specification'' please refer to [https://github.com/msgpack/msgpack/blob/master/spec.md]
  **/
 
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
 #include "Variant.h"
+#include "Registry.h"
 #include "TypeInfo.h"
 #include "Exceptions.h"
 #include "backend/MessagePackBackend.h"
@@ -11,199 +16,650 @@ namespace SimpleRPC
 {
 namespace Backends
 {
-Variant MessagePackBackend::doParse(ByteSeq &data) const
+/* decoder action for each type byte */
+enum class TagKind : uint8_t
 {
-    uint8_t ch;
-    switch ((ch = data.nextBE<uint8_t>()))
-    {
-        /* positive fixint */
-        case 0x00 ... 0x7f:
-            return static_cast<int8_t>(ch & 0x7f);
+    Nil,
+    False,
+    True,
+    PositiveFixInt,
+    NegativeFixInt,
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    UInt8,
+    UInt16,
+    UInt32,
+    UInt64,
+    Float,
+    Double,
+    String,
+    Array,
+    Map,
+    Object,
+    Binary,
+    Extension,
+};
+
+struct Tag
+{
+    TagKind kind;
+    uint8_t width;  /* payload size for scalars, length field size for strings and containers, 0 means length is in the type byte */
+};
 
-        /* nil */
-        case 0xc0:
-            return Variant();
+struct TagTable
+{
+    Tag tags[256];
+};
+
+static constexpr TagTable makeTagTable(void)
+{
+    TagTable table {};
+
+    for (int ch = 0x00; ch <= 0x7f; ch++) table.tags[ch] = { TagKind::PositiveFixInt, 0 };
+    for (int ch = 0x80; ch <= 0x8f; ch++) table.tags[ch] = { TagKind::Map           , 0 };
+    for (int ch = 0x90; ch <= 0x9f; ch++) table.tags[ch] = { TagKind::Array         , 0 };
+    for (int ch = 0xa0; ch <= 0xbf; ch++) table.tags[ch] = { TagKind::String        , 0 };
+    for (int ch = 0xe0; ch <= 0xff; ch++) table.tags[ch] = { TagKind::NegativeFixInt, 0 };
+
+    /* reserved, but we uses it as object */
+    table.tags[0xc1] = { TagKind::Object, 2 };
+
+    table.tags[0xc0] = { TagKind::Nil      , 0 };
+    table.tags[0xc2] = { TagKind::False    , 0 };
+    table.tags[0xc3] = { TagKind::True     , 0 };
+    table.tags[0xc4] = { TagKind::Binary   , 1 };
+    table.tags[0xc5] = { TagKind::Binary   , 2 };
+    table.tags[0xc6] = { TagKind::Binary   , 4 };
+    table.tags[0xc7] = { TagKind::Extension, 1 };
+    table.tags[0xc8] = { TagKind::Extension, 2 };
+    table.tags[0xc9] = { TagKind::Extension, 4 };
+    table.tags[0xca] = { TagKind::Float    , 4 };
+    table.tags[0xcb] = { TagKind::Double   , 8 };
+    table.tags[0xcc] = { TagKind::UInt8    , 1 };
+    table.tags[0xcd] = { TagKind::UInt16   , 2 };
+    table.tags[0xce] = { TagKind::UInt32   , 4 };
+    table.tags[0xcf] = { TagKind::UInt64   , 8 };
+    table.tags[0xd0] = { TagKind::Int8     , 1 };
+    table.tags[0xd1] = { TagKind::Int16    , 2 };
+    table.tags[0xd2] = { TagKind::Int32    , 4 };
+    table.tags[0xd3] = { TagKind::Int64    , 8 };
+    table.tags[0xd4] = { TagKind::Extension, 2 };
+    table.tags[0xd5] = { TagKind::Extension, 3 };
+    table.tags[0xd6] = { TagKind::Extension, 5 };
+    table.tags[0xd7] = { TagKind::Extension, 9 };
+    table.tags[0xd8] = { TagKind::Extension, 17 };
+    table.tags[0xd9] = { TagKind::String   , 1 };
+    table.tags[0xda] = { TagKind::String   , 2 };
+    table.tags[0xdb] = { TagKind::String   , 4 };
+    table.tags[0xdc] = { TagKind::Array    , 2 };
+    table.tags[0xdd] = { TagKind::Array    , 4 };
+    table.tags[0xde] = { TagKind::Map      , 2 };
+    table.tags[0xdf] = { TagKind::Map      , 4 };
+    return table;
+}
+
+static constexpr TagTable Tags = makeTagTable();
+
+/* extension types for packed records, the payload is the class name prefixed by it's length,
+ * the layout fingerprint of the class as an `uint64_t`, then the records with every field in big-endian */
+static const int8_t ExtPackedRecord = 1;
+static const int8_t ExtPackedArray  = 2;
+
+/* `Reader::readObject` keeps the bitmap of read fields on the stack for classes with up to 256 fields */
+static const size_t BitmapWords = 4;
+
+static inline size_t packedWidth(Type::TypeCode type)
+{
+    switch (type)
+    {
+        case Type::TypeCode::Int8    : return sizeof(int8_t  );
+        case Type::TypeCode::Int16   : return sizeof(int16_t );
+        case Type::TypeCode::Int32   : return sizeof(int32_t );
+        case Type::TypeCode::Int64   : return sizeof(int64_t );
+        case Type::TypeCode::UInt8   : return sizeof(uint8_t );
+        case Type::TypeCode::UInt16  : return sizeof(uint16_t);
+        case Type::TypeCode::UInt32  : return sizeof(uint32_t);
+        case Type::TypeCode::UInt64  : return sizeof(uint64_t);
+        case Type::TypeCode::Float   : return sizeof(float   );
+        case Type::TypeCode::Double  : return sizeof(double  );
+        case Type::TypeCode::Boolean : return sizeof(bool    );
 
-        /* reserved, but we uses it as object */
-        case 0xc1:
+        default:
         {
-            /* make an object variant */
-            size_t n = data.nextBE<uint16_t>();
-            Variant result(Type::TypeCode::Object);
+            /* would NEVER happens, packable classes only have primitive fields */
+            abort();
+        }
+    }
+}
 
-            /* parse every entry */
-            while (n--)
-            {
-                Variant key   = doParse(data); /* odd elements in objects are keys of a map */
-                Variant value = doParse(data); /* the next element of a key is its associated value */
+static void swapRecords(char *dest, const char *src, Registry::MetaPtr meta, size_t count, bool validate)
+{
+    /* records are in native byte order in memory, fields are swapped one by one like any other MessagePack numbers */
+    for (size_t i = 0; i < count; i++)
+    {
+        for (const auto &field : meta->fieldList())
+        {
+            Type::TypeCode type = field->type().typeCode();
+            size_t width = packedWidth(type);
 
-                /* add to map */
-                result.internalObject().emplace(
-                    key.get<const std::string &>(),
-                    std::make_shared<Variant>(std::move(value))
-                );
-            }
+            /* bytes from the wire might not be valid booleans */
+            if (validate && (type == Type::TypeCode::Boolean) && (static_cast<uint8_t>(*src) > 1))
+                throw Exceptions::DeserializerError("Invalid boolean in packed record of class \"" + meta->readableName() + "\"");
 
-            /* move to prevent copy */
-            return std::move(result);
+            ByteSeq::swapBytes(dest, src, width, 1);
+            src += width;
+            dest += width;
         }
+    }
+}
 
-        /* false */
-        case 0xc2:
-            return false;
+template <typename T>
+static inline T readBE(const uint8_t *p)
+{
+    T result;
+    std::reverse_copy(p, p + sizeof(T), reinterpret_cast<uint8_t *>(&result));
+    return result;
+}
 
-        /* true */
-        case 0xc3:
-            return true;
+static inline size_t readLength(const uint8_t *p, const Tag &tag)
+{
+    switch (tag.width)
+    {
+        case 1  : return readBE<uint8_t >(p + 1);
+        case 2  : return readBE<uint16_t>(p + 1);
+        case 4  : return readBE<uint32_t>(p + 1);
+        default : return *p & (tag.kind == TagKind::String ? 0x1f : 0x0f);
+    }
+}
+
+static inline size_t extensionSize(const uint8_t *p, const Tag &tag, size_t &header)
+{
+    /* fixext has the payload size in the type byte, followed by the extension type */
+    if (*p >= 0xd4)
+    {
+        header = 2;
+        return tag.width - 1;
+    }
+
+    /* ext 8/16/32 has a length field before the extension type */
+    header = tag.width + 2;
+    return readLength(p, tag);
+}
+
+static Variant readExtension(const uint8_t *p, size_t header, size_t size)
+{
+    int8_t type = static_cast<int8_t>(p[header - 1]);
+    const uint8_t *data = p + header;
+
+    /* no other extensions for now */
+    if ((type != ExtPackedRecord) && (type != ExtPackedArray))
+        throw Exceptions::DeserializerError("Unknown extension type " + std::to_string(type));
+
+    /* class name and layout fingerprint */
+    if ((size < 1) || (size - 1 < data[0] + sizeof(uint64_t)))
+        throw Exceptions::DeserializerError("Truncated packed record");
+
+    std::string name(reinterpret_cast<const char *>(data + 1), data[0]);
+    Registry::MetaPtr meta = &Registry::findClass(name);
+
+    /* records must have the same layout on both sides, not only the same size */
+    const uint8_t *records = data + data[0] + 1 + sizeof(uint64_t);
+    size_t length = size - data[0] - 1 - sizeof(uint64_t);
+    size_t packedSize = meta->packedSize();
+
+    if (!packedSize)
+        throw Exceptions::DeserializerError("Class \"" + meta->readableName() + "\" can't be packed");
+
+    if (readBE<uint64_t>(data + data[0] + 1) != meta->layout())
+        throw Exceptions::DeserializerError("Packed record layout mismatch for class \"" + meta->readableName() + "\"");
+
+    if ((type == ExtPackedRecord) ? (length != packedSize) : (length % packedSize))
+        throw Exceptions::DeserializerError("Packed record size mismatch for class \"" + meta->readableName() + "\"");
+
+    /* records are copied out of the message in native byte order, they are usually unpacked much later */
+    ByteSeq copy;
+    swapRecords(copy.preserve(length), reinterpret_cast<const char *>(records), meta, length / packedSize, true);
+    copy.commit(length);
 
-        /* bin8/16/32 */
-        case 0xc4:
-        case 0xc5:
-        case 0xc6:
+    return Variant(
+        (type == ExtPackedRecord) ? Type::TypeCode::Object : Type::TypeCode::Array,
+        std::make_shared<Variant::PackedLoader>(meta, std::move(copy), length / packedSize)
+    );
+}
+
+template <typename T>
+static inline T canonicalReal(T value)
+{
+    /* all NaNs are encoded as the same quiet NaN, and negative zero as zero since they compare equal */
+    if (std::isnan(value))
+        return std::numeric_limits<T>::quiet_NaN();
+    else if (value == 0)
+        return 0;
+    else
+        return value;
+}
+
+static inline Type::TypeCode containerType(TagKind kind)
+{
+    switch (kind)
+    {
+        case TagKind::Map   : return Type::TypeCode::Map;
+        case TagKind::Array : return Type::TypeCode::Array;
+        default             : return Type::TypeCode::Object;
+    }
+}
+
+static inline Variant readScalar(const uint8_t *p, const Tag &tag)
+{
+    switch (tag.kind)
+    {
+        case TagKind::Nil            : return Variant();
+        case TagKind::False          : return false;
+        case TagKind::True           : return true;
+        case TagKind::PositiveFixInt : return static_cast<int8_t>(*p & 0x7f);
+        case TagKind::NegativeFixInt : return static_cast<int8_t>(*p);
+
+        case TagKind::Int8           : return readBE<int8_t  >(p + 1);
+        case TagKind::Int16          : return readBE<int16_t >(p + 1);
+        case TagKind::Int32          : return readBE<int32_t >(p + 1);
+        case TagKind::Int64          : return readBE<int64_t >(p + 1);
+
+        case TagKind::UInt8          : return readBE<uint8_t >(p + 1);
+        case TagKind::UInt16         : return readBE<uint16_t>(p + 1);
+        case TagKind::UInt32         : return readBE<uint32_t>(p + 1);
+        case TagKind::UInt64         : return readBE<uint64_t>(p + 1);
+
+        case TagKind::Float          : return readBE<float   >(p + 1);
+        case TagKind::Double         : return readBE<double  >(p + 1);
+
+        case TagKind::Binary:
             throw Exceptions::DeserializerError("\"Binary\" types are reserved for future purpose");
 
-        /* ext8/16/32 */
-        case 0xc7:
-        case 0xc8:
-        case 0xc9:
+        case TagKind::Extension:
             throw Exceptions::DeserializerError("\"Extension\" types are reserved for future purpose");
 
-        /* float */
-        case 0xca:
-            return data.nextBE<float>();
+        default:
+        {
+            /* would NEVER happens */
+            abort();
+        }
+    }
+}
 
-        /* double */
-        case 0xcb:
-            return data.nextBE<double>();
+void MessagePackBackend::KeyDictionary::clear(void)
+{
+    _ids.clear();
+    _keys.clear();
+}
 
-        /* uint8 */
-        case 0xcc:
-            return data.nextBE<uint8_t>();
+void MessagePackBackend::KeyDictionary::add(const std::string &key)
+{
+    /* both sides stop registering when the table is full, so they are still in sync */
+    if ((_keys.size() < _capacity) && _ids.emplace(key, static_cast<uint32_t>(_keys.size())).second)
+        _keys.push_back(key);
+}
 
-        /* uint16 */
-        case 0xcd:
-            return data.nextBE<uint16_t>();
+bool MessagePackBackend::KeyDictionary::find(const std::string &key, uint32_t &id) const
+{
+    auto iter = _ids.find(key);
 
-        /* uint32 */
-        case 0xce:
-            return data.nextBE<uint32_t>();
+    /* not registered yet */
+    if (iter == _ids.end())
+        return false;
 
-        /* uint64 */
-        case 0xcf:
-            return data.nextBE<uint64_t>();
+    id = iter->second;
+    return true;
+}
 
-        /* int8 */
-        case 0xd0:
-            return data.nextBE<int8_t>();
+const std::string &MessagePackBackend::KeyDictionary::key(const Variant &ref) const
+{
+    size_t id;
 
-        /* int16 */
-        case 0xd1:
-            return data.nextBE<int16_t>();
+    /* references are always encoded as unsigned numbers */
+    switch (ref.type())
+    {
+        case Type::TypeCode::Int8   : id = static_cast<size_t>(ref.get<int8_t>()); break;
+        case Type::TypeCode::UInt8  : id = ref.get<uint8_t>(); break;
+        case Type::TypeCode::UInt16 : id = ref.get<uint16_t>(); break;
+        case Type::TypeCode::UInt32 : id = ref.get<uint32_t>(); break;
 
-        /* int32 */
-        case 0xd2:
-            return data.nextBE<int32_t>();
+        default:
+            throw Exceptions::DeserializerError("Invalid key reference " + ref.toString());
+    }
 
-        /* int64 */
-        case 0xd3:
-            return data.nextBE<int64_t>();
+    /* must be registered before */
+    if (id >= _keys.size())
+        throw Exceptions::DeserializerError("Unknown key reference " + std::to_string(id));
 
-        /* fixext1/2/4/8/16 */
-        case 0xd4:
-        case 0xd5:
-        case 0xd6:
-        case 0xd7:
-        case 0xd8:
-            throw Exceptions::DeserializerError("\"Extension\" types are reserved for future purpose");
+    return _keys[id];
+}
 
-        /* str8/16/32 */
-        case 0xd9:
-        case 0xda:
-        case 0xdb:
+bool MessagePackBackend::attach(std::vector<Frame> &stack, std::shared_ptr<Variant> &value, KeyDictionary *keys)
+{
+    /* attach the value to it's parent, and close parents that are full */
+    while (!stack.empty())
+    {
+        /* the innermost container */
+        Frame &top = stack.back();
 
-        /* fixstr */
-        case 0xa0 ... 0xbf:
+        switch (top.value->type())
         {
-            size_t n =
-                ch == 0xd9 ? data.nextBE<uint8_t >() :  /* str8   */
-                ch == 0xda ? data.nextBE<uint16_t>() :  /* str16  */
-                ch == 0xdb ? data.nextBE<uint32_t>() :  /* str32  */
-                static_cast<size_t>(ch & 0x1f);         /* fixstr */
+            case Type::TypeCode::Array:
+            {
+                top.value->internalArray().push_back(std::move(value));
+                break;
+            }
 
-            /* extract string from buffer */
-            return std::string(data.consume(n), n);
+            case Type::TypeCode::Map:
+            {
+                /* odd elements in maps are keys, wait for it's value */
+                if (!top.key)
+                {
+                    top.key = std::move(value);
+                    return false;
+                }
+
+                /* add to map */
+                top.value->internalMap().emplace(VariantHashKey(std::move(top.key)), std::move(value));
+                break;
+            }
+
+            case Type::TypeCode::Object:
+            {
+                /* field names of objects must be strings, or references when using key dictionary */
+                if (!top.key)
+                {
+                    if (!keys)
+                        value->get<const std::string &>();
+                    else if (value->type() == Type::TypeCode::String)
+                        keys->add(value->get<const std::string &>());
+                    else
+                        value = std::make_shared<Variant>(keys->key(*value));
+
+                    top.key = std::move(value);
+                    return false;
+                }
+
+                /* add to object */
+                top.value->internalObject().emplace(top.key->get<const std::string &>(), std::move(value));
+                top.key.reset();
+                break;
+            }
+
+            default:
+            {
+                /* would NEVER happens */
+                abort();
+            }
         }
 
-        /* array16/32 */
-        case 0xdc:
-        case 0xdd:
+        /* container still has items to fill */
+        if (--top.remains)
+            return false;
 
-        /* fixarray */
-        case 0x90 ... 0x9f:
-        {
-            size_t n =
-                ch == 0xdc ? data.nextBE<uint16_t>() :  /* array16  */
-                ch == 0xdd ? data.nextBE<uint32_t>() :  /* array32  */
-                static_cast<size_t>(ch & 0x0f);         /* fixarray */
+        /* container is full, attach to it's parent */
+        value = std::move(top.value);
+        stack.pop_back();
+    }
 
-            /* make an array variant */
-            Variant result(Type::TypeCode::Array);
+    /* top-level value is complete */
+    return true;
+}
 
-            /* parse each element */
-            while (n--)
-                result.internalArray().push_back(std::make_shared<Variant>(doParse(data)));
+Variant MessagePackBackend::decode(const uint8_t *&p, const uint8_t *end, KeyDictionary *keys)
+{
+    std::vector<Frame> stack;
+    std::shared_ptr<Variant> value;
 
-            /* move to prevent copy */
-            return std::move(result);
+    for (;;)
+    {
+        /* fast path for runs of positive fixint or fixstr in arrays, the last one is left for `attach` to close the array */
+        if (!stack.empty() && (stack.back().value->type() == Type::TypeCode::Array))
+        {
+            Frame &top = stack.back();
+            Variant::Array &array = top.value->internalArray();
+
+            while ((top.remains > 1) && (p < end))
+            {
+                if (*p < 0x80)
+                {
+                    array.push_back(std::make_shared<Variant>(static_cast<int8_t>(*p++)));
+                }
+                else if (((*p & 0xe0) == 0xa0) && ((*p & 0x1f) < end - p))
+                {
+                    array.push_back(std::make_shared<Variant>(std::string(reinterpret_cast<const char *>(p + 1), *p & 0x1f)));
+                    p += (*p & 0x1f) + 1;
+                }
+                else
+                {
+                    break;
+                }
+
+                top.remains--;
+            }
         }
 
-        /* map16/32 */
-        case 0xde:
-        case 0xdf:
+        /* no data left */
+        if (p >= end)
+            throw Exceptions::BufferOverflowError(0);
 
-        /* fixmap */
-        case 0x80 ... 0x8f:
+        /* bytes left after the type byte */
+        const Tag &tag = Tags.tags[*p];
+        size_t size = static_cast<size_t>(end - p - 1);
+
+        /* length field or the scalar payload */
+        if (size < tag.width)
+            throw Exceptions::BufferOverflowError(size);
+
+        switch (tag.kind)
         {
-            size_t n =
-                ch == 0xde ? data.nextBE<uint16_t>() :  /* map16  */
-                ch == 0xdf ? data.nextBE<uint32_t>() :  /* map32  */
-                static_cast<size_t>(ch & 0x0f);         /* fixmap */
+            case TagKind::String:
+            {
+                size_t n = readLength(p, tag);
+                p += tag.width + 1;
 
-            /* make an object variant */
-            Variant result(Type::TypeCode::Map);
+                /* extract string from buffer */
+                if (n > size - tag.width)
+                    throw Exceptions::BufferOverflowError(size - tag.width);
 
-            /* parse every entry */
-            while (n--)
+                value = std::make_shared<Variant>(std::string(reinterpret_cast<const char *>(p), n));
+                p += n;
+                break;
+            }
+
+            case TagKind::Map:
+            case TagKind::Array:
+            case TagKind::Object:
             {
-                Variant key   = doParse(data); /* odd elements in objects are keys of a map */
-                Variant value = doParse(data); /* the next element of a key is its associated value */
+                size_t n = readLength(p, tag);
+                p += tag.width + 1;
 
-                /* add to map */
-                result.internalMap().emplace(
-                    VariantHashKey(std::move(key)),
-                    std::make_shared<Variant>(std::move(value))
-                );
+                /* empty containers are completed immediately */
+                if (!n)
+                {
+                    value = std::make_shared<Variant>(containerType(tag.kind));
+                    break;
+                }
+
+                /* every item takes at least one byte, so check bounds for the whole container at once */
+                if (n > (size - tag.width) / (tag.kind == TagKind::Array ? 1 : 2))
+                    throw Exceptions::BufferOverflowError(size - tag.width);
+
+                /* open a new container */
+                stack.emplace_back(containerType(tag.kind), n);
+
+                /* reserve space to prevent frequent malloc */
+                if (tag.kind == TagKind::Array)
+                    stack.back().value->internalArray().reserve(n);
+
+                continue;
+            }
+
+            case TagKind::Extension:
+            {
+                size_t header;
+                size_t n = extensionSize(p, tag, header);
+
+                /* extension type and payload */
+                if (header + n > size + 1)
+                    throw Exceptions::BufferOverflowError(size);
+
+                value = std::make_shared<Variant>(readExtension(p, header, n));
+                p += header + n;
+                break;
             }
 
-            /* move to prevent copy */
-            return std::move(result);
+            default:
+            {
+                value = std::make_shared<Variant>(readScalar(p, tag));
+                p += tag.width + 1;
+                break;
+            }
         }
 
-        /* negative fixint */
-        case 0xe0 ... 0xff:
-            return static_cast<int8_t>(ch);
+        /* the top-level value is complete */
+        if (attach(stack, value, keys))
+            break;
+    }
 
-        default:
+    /* nobody else refers to the top-level value */
+    return std::move(*value);
+}
+
+const uint8_t *MessagePackBackend::skip(const uint8_t *p, const uint8_t *end, size_t count)
+{
+    /* count of values to skip, containers add their items */
+    while (count--)
+    {
+        /* no data left */
+        if (p >= end)
+            throw Exceptions::BufferOverflowError(0);
+
+        /* bytes left after the type byte */
+        const Tag &tag = Tags.tags[*p];
+        size_t size = static_cast<size_t>(end - p - 1);
+
+        /* length field or the scalar payload */
+        if (size < tag.width)
+            throw Exceptions::BufferOverflowError(size);
+
+        switch (tag.kind)
         {
-            /* would NEVER happens */
-            abort();
+            case TagKind::String:
+            {
+                size_t n = readLength(p, tag);
+
+                /* skip the whole string */
+                if (n > size - tag.width)
+                    throw Exceptions::BufferOverflowError(size - tag.width);
+
+                p += tag.width + n + 1;
+                break;
+            }
+
+            case TagKind::Map:
+            case TagKind::Object:
+            {
+                count += readLength(p, tag) * 2;
+                p += tag.width + 1;
+                break;
+            }
+
+            case TagKind::Array:
+            {
+                count += readLength(p, tag);
+                p += tag.width + 1;
+                break;
+            }
+
+            case TagKind::Binary:
+                throw Exceptions::DeserializerError("\"Binary\" types are reserved for future purpose");
+
+            case TagKind::Extension:
+            {
+                size_t header;
+                size_t n = extensionSize(p, tag, header);
+
+                /* skip the whole extension */
+                if (header + n > size + 1)
+                    throw Exceptions::BufferOverflowError(size);
+
+                p += header + n;
+                break;
+            }
+
+            default:
+            {
+                p += tag.width + 1;
+                break;
+            }
         }
     }
+
+    return p;
+}
+
+Variant MessagePackBackend::doParse(ByteSeq &data, KeyDictionary *keys) const
+{
+    /* decode directly from the buffer */
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data.data());
+    const uint8_t *begin = p;
+
+    /* consume all bytes that parsed at once */
+    Variant value = decode(p, p + data.length(), keys);
+    data.consume(p - begin);
+    return value;
 }
 
-ByteSeq MessagePackBackend::doAssemble(Variant &object) const
+ByteSeq MessagePackBackend::doAssemble(Variant &object, KeyDictionary *keys, bool canonical) const
 {
     ByteSeq result;
+    const Variant::PackedLoader *packed = object.packed();
+
+    /* packed records are sent as they are, except in canonical form, which must not depend on how values are built */
+    if (!canonical && packed && (packed->meta->name().size() <= UINT8_MAX))
+    {
+        const std::string &name = packed->meta->name();
+        size_t size = packed->data.length() + name.size() + 1 + sizeof(uint64_t);
+
+        if (size <= UINT8_MAX)
+        {
+            /* ext8 */
+            result.appendBE((uint8_t)0xc7);
+            result.appendBE(static_cast<uint8_t>(size));
+        }
+        else if (size <= UINT16_MAX)
+        {
+            /* ext16 */
+            result.appendBE((uint8_t)0xc8);
+            result.appendBE(static_cast<uint16_t>(size));
+        }
+        else if (size <= UINT32_MAX)
+        {
+            /* ext32 */
+            result.appendBE((uint8_t)0xc9);
+            result.appendBE(static_cast<uint32_t>(size));
+        }
+        else
+        {
+            /* records are too large */
+            throw Exceptions::SerializerError("Packed records are too large : " + std::to_string(size));
+        }
+
+        /* extension type, class name, layout fingerprint, then records */
+        result.appendBE((object.type() == Type::TypeCode::Object) ? ExtPackedRecord : ExtPackedArray);
+        result.appendBE(static_cast<uint8_t>(name.size()));
+        result.append(name);
+        result.appendBE(packed->meta->layout());
+
+        /* fields are swapped into big-endian */
+        swapRecords(result.preserve(packed->data.length()), packed->data.data(), packed->meta, packed->count, false);
+        result.commit(packed->data.length());
+        return std::move(result);
+    }
+
     switch (object.type())
     {
         case Type::TypeCode::Void:
@@ -283,14 +739,14 @@ ByteSeq MessagePackBackend::doAssemble(Variant &object) const
         case Type::TypeCode::Float:
         {
             result.appendBE((uint8_t)0xca);
-            result.appendBE(object.get<float>());
+            result.appendBE(canonical ? canonicalReal(object.get<float>()) : object.get<float>());
             break;
         }
 
         case Type::TypeCode::Double:
         {
             result.appendBE((uint8_t)0xcb);
-            result.appendBE(object.get<double>());
+            result.appendBE(canonical ? canonicalReal(object.get<double>()) : object.get<double>());
             break;
         }
 
@@ -309,7 +765,7 @@ ByteSeq MessagePackBackend::doAssemble(Variant &object) const
             /* get as reference to prevent copy */
             const std::string &s = object.get<const std::string &>();
 
-            if (s.size() < 31)
+            if (s.size() <= 31)
             {
                 /* fixstr */
                 result.appendBE(static_cast<uint8_t>(0xa0 | s.size()));
@@ -369,10 +825,36 @@ ByteSeq MessagePackBackend::doAssemble(Variant &object) const
             }
 
             /* serialize each object */
+            if (!canonical)
+            {
+                for (const auto &item : object.internalMap())
+                {
+                    result.append(doAssemble(*item.first.key, keys, false));
+                    result.append(doAssemble(*item.second, keys, false));
+                }
+
+                break;
+            }
+
+            /* canonical keys are sorted by their encoded bytes, which never depends on the key dictionary */
+            std::vector<std::pair<ByteSeq, const Variant::Map::value_type *>> items;
+            items.reserve(object.internalMap().size());
+
             for (const auto &item : object.internalMap())
+                items.emplace_back(doAssemble(*item.first.key, nullptr, true), &item);
+
+            std::sort(items.begin(), items.end(), [](const auto &a, const auto &b)
+            {
+                size_t size = std::min(a.first.length(), b.first.length());
+                int ret = memcmp(a.first.data(), b.first.data(), size);
+                return (ret < 0) || ((ret == 0) && (a.first.length() < b.first.length()));
+            });
+
+            /* keys are encoded again when using key dictionary, to register names in the order they are sent */
+            for (auto &item : items)
             {
-                result.append(doAssemble(*item.first.key));
-                result.append(doAssemble(*item.second));
+                result.append(keys ? doAssemble(*item.second->first.key, keys, true) : std::move(item.first));
+                result.append(doAssemble(*item.second->second, keys, true));
             }
 
             break;
@@ -405,7 +887,7 @@ ByteSeq MessagePackBackend::doAssemble(Variant &object) const
 
             /* serialize each object */
             for (const auto &item : object.internalArray())
-                result.append(doAssemble(*item));
+                result.append(doAssemble(*item, keys, canonical));
 
             break;
         }
@@ -420,11 +902,63 @@ ByteSeq MessagePackBackend::doAssemble(Variant &object) const
             result.appendBE((uint8_t)0xc1);
             result.appendBE(static_cast<uint16_t>(object.internalObject().size()));
 
-            /* serialize each object */
-            for (const auto &item : object.internalObject())
+            /* serialize each field */
+            auto field = [&](const Variant::Object::value_type &item)
+            {
+                uint32_t id;
+
+                /* names that already sent are replaced by their references */
+                if (!keys || !keys->find(item.first, id))
+                {
+                    /* register the name after sending it in full */
+                    result.append(assemble(item.first));
+
+                    if (keys)
+                        keys->add(item.first);
+                }
+                else if (id <= 0x7f)
+                {
+                    /* positive fixint */
+                    result.appendBE(static_cast<uint8_t>(id));
+                }
+                else if (id <= UINT8_MAX)
+                {
+                    /* uint8 */
+                    result.appendBE((uint8_t)0xcc);
+                    result.appendBE(static_cast<uint8_t>(id));
+                }
+                else if (id <= UINT16_MAX)
+                {
+                    /* uint16 */
+                    result.appendBE((uint8_t)0xcd);
+                    result.appendBE(static_cast<uint16_t>(id));
+                }
+                else
+                {
+                    /* uint32 */
+                    result.appendBE((uint8_t)0xce);
+                    result.appendBE(id);
+                }
+
+                result.append(doAssemble(*item.second, keys, canonical));
+            };
+
+            /* canonical fields are sorted by name */
+            if (!canonical)
+            {
+                for (const auto &item : object.internalObject())
+                    field(item);
+            }
+            else
             {
-                result.append(assemble(item.first));
-                result.append(doAssemble(*item.second));
+                std::vector<const Variant::Object::value_type *> fields;
+                fields.reserve(object.internalObject().size());
+
+                for (const auto &item : object.internalObject())
+                    fields.push_back(&item);
+
+                std::sort(fields.begin(), fields.end(), [](const auto *a, const auto *b) { return a->first < b->first; });
+                std::for_each(fields.begin(), fields.end(), [&](const auto *item) { field(*item); });
             }
 
             break;
@@ -435,7 +969,537 @@ ByteSeq MessagePackBackend::doAssemble(Variant &object) const
     return std::move(result);
 }
 
+void MessagePackBackend::Parser::reset(void)
+{
+    _done = false;
+    _stack.clear();
+    _buffer.clear();
+    _result = Variant();
+}
+
+Variant MessagePackBackend::Parser::result(void)
+{
+    /* value must be completed */
+    if (!_done)
+        throw Exceptions::RuntimeError("Incomplete message, " + std::to_string(_stack.size()) + " container(s) still open");
+
+    /* ready for next message, bytes that already buffered are preserved */
+    _done = false;
+    return std::move(_result);
+}
+
+bool MessagePackBackend::Parser::feed(const void *data, size_t size)
+{
+    /* buffer the new chunk */
+    if (size)
+        _buffer.append(data, size);
+
+    /* parse as much as we can */
+    while (!_done && step());
+    return _done;
+}
+
+bool MessagePackBackend::Parser::step(void)
+{
+    /* wait for more data */
+    if (!_buffer.length())
+        return false;
+
+    /* peek the type byte, but don't consume it yet */
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(_buffer.data());
+    const Tag &tag = Tags.tags[*p];
+
+    /* bytes left after the type byte */
+    size_t size = _buffer.length() - 1;
+
+    /* wait until the length field or the scalar payload is complete */
+    if (size < tag.width)
+        return false;
+
+    switch (tag.kind)
+    {
+        case TagKind::String:
+        {
+            size_t n = readLength(p, tag);
+
+            /* wait until the whole string arrived */
+            if (n > size - tag.width)
+                return false;
+
+            /* extract string from buffer */
+            Variant value(std::string(_buffer.consume(tag.width + n + 1) + tag.width + 1, n));
+            complete(std::move(value));
+            return true;
+        }
+
+        case TagKind::Map:
+        case TagKind::Array:
+        case TagKind::Object:
+        {
+            size_t n = readLength(p, tag);
+            Type::TypeCode type = containerType(tag.kind);
+
+            /* header is complete, skip it */
+            _buffer.consume(tag.width + 1);
+
+            /* empty containers are completed immediately */
+            if (!n)
+            {
+                complete(Variant(type));
+                return true;
+            }
+
+            /* check for nesting depth */
+            if (_stack.size() >= _maxDepth)
+                throw Exceptions::DeserializerError("Nesting depth exceeds limit : " + std::to_string(_maxDepth));
+
+            /* open a new container */
+            _stack.emplace_back(type, n);
+            return true;
+        }
+
+        case TagKind::Extension:
+        {
+            size_t header;
+            size_t n = extensionSize(p, tag, header);
+
+            /* wait until the whole extension arrived */
+            if (header + n > size + 1)
+                return false;
+
+            /* extract records from buffer */
+            Variant value = readExtension(p, header, n);
+            _buffer.consume(header + n);
+            complete(std::move(value));
+            return true;
+        }
+
+        default:
+        {
+            Variant value = readScalar(p, tag);
+            _buffer.consume(tag.width + 1);
+            complete(std::move(value));
+            return true;
+        }
+    }
+}
+
+void MessagePackBackend::Parser::complete(Variant &&value)
+{
+    /* attach to parent containers, the message is complete if it's the top-level value */
+    std::shared_ptr<Variant> item = std::make_shared<Variant>(std::move(value));
+    if (attach(_stack, item))
+    {
+        _done = true;
+        _result = std::move(*item);
+    }
+}
+
+bool MessagePackBackend::Reader::advance(void)
+{
+    /* the top-level value */
+    if (_stack.empty())
+    {
+        _started = true;
+        return false;
+    }
+
+    /* odd elements in objects are field names */
+    Level &top = _stack.back();
+    bool isKey = (top.type == Type::TypeCode::Object) && !(top.remains % 2);
+
+    /* one less item in the container */
+    top.remains--;
+    return isKey;
+}
+
+MessagePackBackend::Reader::Event MessagePackBackend::Reader::next(void)
+{
+    /* close containers that are exhausted */
+    if (!_stack.empty() && !_stack.back().remains)
+    {
+        _stack.pop_back();
+        return _event = Event::End;
+    }
+
+    /* only one top-level value in a message */
+    if (_stack.empty() && _started)
+        return _event = Event::Finish;
+
+    /* no data left */
+    bool isKey = advance();
+    if (_p >= _end)
+        throw Exceptions::BufferOverflowError(0);
+
+    /* bytes left after the type byte */
+    const Tag &tag = Tags.tags[*_p];
+    size_t size = static_cast<size_t>(_end - _p - 1);
+
+    /* length field or the scalar payload */
+    if (size < tag.width)
+        throw Exceptions::BufferOverflowError(size);
+
+    /* string is the only possible type of field names */
+    if (isKey && (tag.kind != TagKind::String))
+        throw Exceptions::DeserializerError("Field names of objects must be strings");
+
+    switch (tag.kind)
+    {
+        case TagKind::String:
+        {
+            _type = Type::TypeCode::String;
+            _length = readLength(_p, tag);
+
+            /* refer to the string in buffer */
+            if (_length > size - tag.width)
+                throw Exceptions::BufferOverflowError(size - tag.width);
+
+            _string = reinterpret_cast<const char *>(_p + tag.width + 1);
+            _p += tag.width + _length + 1;
+            return _event = isKey ? Event::Key : Event::String;
+        }
+
+        case TagKind::Map:
+        case TagKind::Array:
+        case TagKind::Object:
+        {
+            _type = containerType(tag.kind);
+            _length = readLength(_p, tag);
+            _p += tag.width + 1;
+
+            /* keys and values of maps and objects are counted separately */
+            if (tag.kind == TagKind::Array)
+            {
+                _stack.emplace_back(_type, _length);
+                return _event = Event::BeginArray;
+            }
+            else
+            {
+                _stack.emplace_back(_type, _length * 2);
+                return _event = (tag.kind == TagKind::Map) ? Event::BeginMap : Event::BeginObject;
+            }
+        }
+
+        default:
+            break;
+    }
+
+    switch (tag.kind)
+    {
+        case TagKind::Nil            : _event = Event::Nil;             _type = Type::TypeCode::Void;    break;
+        case TagKind::False          : _event = Event::Boolean;         _type = Type::TypeCode::Boolean; _bool     = false;                      break;
+        case TagKind::True           : _event = Event::Boolean;         _type = Type::TypeCode::Boolean; _bool     = true;                       break;
+        case TagKind::PositiveFixInt : _event = Event::Integer;         _type = Type::TypeCode::Int8;    _integer  = *_p & 0x7f;                 break;
+        case TagKind::NegativeFixInt : _event = Event::Integer;         _type = Type::TypeCode::Int8;    _integer  = static_cast<int8_t>(*_p);   break;
+
+        case TagKind::Int8           : _event = Event::Integer;         _type = Type::TypeCode::Int8;    _integer  = readBE<int8_t  >(_p + 1);   break;
+        case TagKind::Int16          : _event = Event::Integer;         _type = Type::TypeCode::Int16;   _integer  = readBE<int16_t >(_p + 1);   break;
+        case TagKind::Int32          : _event = Event::Integer;         _type = Type::TypeCode::Int32;   _integer  = readBE<int32_t >(_p + 1);   break;
+        case TagKind::Int64          : _event = Event::Integer;         _type = Type::TypeCode::Int64;   _integer  = readBE<int64_t >(_p + 1);   break;
+
+        case TagKind::UInt8          : _event = Event::UnsignedInteger; _type = Type::TypeCode::UInt8;   _unsigned = readBE<uint8_t >(_p + 1);   break;
+        case TagKind::UInt16         : _event = Event::UnsignedInteger; _type = Type::TypeCode::UInt16;  _unsigned = readBE<uint16_t>(_p + 1);   break;
+        case TagKind::UInt32         : _event = Event::UnsignedInteger; _type = Type::TypeCode::UInt32;  _unsigned = readBE<uint32_t>(_p + 1);   break;
+        case TagKind::UInt64         : _event = Event::UnsignedInteger; _type = Type::TypeCode::UInt64;  _unsigned = readBE<uint64_t>(_p + 1);   break;
+
+        case TagKind::Float          : _event = Event::Real;            _type = Type::TypeCode::Float;   _real     = readBE<float   >(_p + 1);   break;
+        case TagKind::Double         : _event = Event::Real;            _type = Type::TypeCode::Double;  _real     = readBE<double  >(_p + 1);   break;
+
+        case TagKind::Binary:
+            throw Exceptions::DeserializerError("\"Binary\" types are reserved for future purpose");
+
+        case TagKind::Extension:
+            throw Exceptions::DeserializerError("Packed records can only be read as whole values");
+
+        default:
+        {
+            /* would NEVER happens */
+            abort();
+        }
+    }
+
+    /* skip the scalar */
+    _p += tag.width + 1;
+    return _event;
+}
+
+Variant MessagePackBackend::Reader::read(void)
+{
+    /* no values left in current container */
+    if (!_stack.empty() && !_stack.back().remains)
+        throw Exceptions::DeserializerError("No values left in container");
+
+    /* only one top-level value in a message */
+    if (_stack.empty() && _started)
+        throw Exceptions::DeserializerError("No values left in message");
+
+    /* materialize the whole value */
+    advance();
+    return decode(_p, _end);
+}
+
+void MessagePackBackend::Reader::skip(void)
+{
+    /* not inside any container */
+    if (_stack.empty())
+        return;
+
+    /* skip all remaining items, and close the container */
+    _p = MessagePackBackend::skip(_p, _end, _stack.back().remains);
+    _stack.pop_back();
+    _event = Event::End;
+}
+
+void MessagePackBackend::Reader::readObject(Serializable &object)
+{
+    /* must be an object */
+    if (next() != Event::BeginObject)
+        throw Exceptions::TypeError("Value is not an object");
+
+    Serializable::MetaClass meta = object.meta();
+    const auto &fields = meta.fieldList();
+
+    /* one bit per field that have been read, in field order */
+    size_t count = 0;
+    size_t words = (fields.size() + 63) / 64;
+    uint64_t stack[BitmapWords];
+    std::vector<uint64_t> heap;
+    uint64_t *filled = stack;
+
+    /* too many fields for the stack */
+    if (words > BitmapWords)
+    {
+        heap.resize(words);
+        filled = heap.data();
+    }
+
+    /* read every field */
+    std::fill_n(filled, words, 0);
+    while (next() == Event::Key)
+    {
+        ssize_t index = meta.indexOf(_string, _length);
+
+        /* not found, it's an error */
+        if (index < 0)
+            throw Exceptions::ReflectionError("No such field \"" + string() + "\"");
+
+        /* each field can only appear once */
+        uint64_t bit = 1ull << (index % 64);
+        if (filled[index / 64] & bit)
+            throw Exceptions::ReflectionError("Duplicated field \"" + string() + "\"");
+
+        /* write directly into field */
+        count++;
+        filled[index / 64] |= bit;
+        readField(*fields[index], object);
+    }
+
+    /* all fields must present */
+    if (count != fields.size())
+        for (size_t i = 0; i < fields.size(); i++)
+            if (!(filled[i / 64] & (1ull << (i % 64))))
+                throw Exceptions::ReflectionError("Missing field \"" + fields[i]->name() + "\"");
+}
+
+void MessagePackBackend::Reader::readField(Field &field, Serializable &object)
+{
+    switch (field.type().typeCode())
+    {
+        /* compound types are materialized and delegated to field deserializer */
+        case Type::TypeCode::Map:
+        case Type::TypeCode::Array:
+        case Type::TypeCode::Object:
+        {
+            field.deserialize(&object, read());
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    /* no value for this field */
+    if (next() == Event::End)
+        throw Exceptions::DeserializerError("No values left in container");
+
+    /* anything other than the exact type goes through field deserializer, so it accepts exactly what `Variant::get` does */
+    if (_type != field.type().typeCode())
+    {
+        field.deserialize(&object, scalar());
+        return;
+    }
+
+    switch (_type)
+    {
+        case Type::TypeCode::Int8    : field.data<int8_t     >(&object) = static_cast<int8_t  >(_integer ); break;
+        case Type::TypeCode::Int16   : field.data<int16_t    >(&object) = static_cast<int16_t >(_integer ); break;
+        case Type::TypeCode::Int32   : field.data<int32_t    >(&object) = static_cast<int32_t >(_integer ); break;
+        case Type::TypeCode::Int64   : field.data<int64_t    >(&object) = static_cast<int64_t >(_integer ); break;
+
+        case Type::TypeCode::UInt8   : field.data<uint8_t    >(&object) = static_cast<uint8_t >(_unsigned); break;
+        case Type::TypeCode::UInt16  : field.data<uint16_t   >(&object) = static_cast<uint16_t>(_unsigned); break;
+        case Type::TypeCode::UInt32  : field.data<uint32_t   >(&object) = static_cast<uint32_t>(_unsigned); break;
+        case Type::TypeCode::UInt64  : field.data<uint64_t   >(&object) = static_cast<uint64_t>(_unsigned); break;
+
+        case Type::TypeCode::Float   : field.data<float      >(&object) = static_cast<float   >(_real    ); break;
+        case Type::TypeCode::Double  : field.data<double     >(&object) = static_cast<double  >(_real    ); break;
+        case Type::TypeCode::Boolean : field.data<bool       >(&object) = _bool;                            break;
+        case Type::TypeCode::String  : field.data<std::string>(&object).assign(_string, _length);           break;
+
+        default:
+        {
+            /* would NEVER happens */
+            abort();
+        }
+    }
+}
+
+Variant MessagePackBackend::Reader::scalar(void) const
+{
+    switch (_type)
+    {
+        case Type::TypeCode::Int8    : return Variant(static_cast<int8_t  >(_integer ));
+        case Type::TypeCode::Int16   : return Variant(static_cast<int16_t >(_integer ));
+        case Type::TypeCode::Int32   : return Variant(static_cast<int32_t >(_integer ));
+        case Type::TypeCode::Int64   : return Variant(static_cast<int64_t >(_integer ));
+
+        case Type::TypeCode::UInt8   : return Variant(static_cast<uint8_t >(_unsigned));
+        case Type::TypeCode::UInt16  : return Variant(static_cast<uint16_t>(_unsigned));
+        case Type::TypeCode::UInt32  : return Variant(static_cast<uint32_t>(_unsigned));
+        case Type::TypeCode::UInt64  : return Variant(static_cast<uint64_t>(_unsigned));
+
+        case Type::TypeCode::Float   : return Variant(static_cast<float   >(_real    ));
+        case Type::TypeCode::Double  : return Variant(static_cast<double  >(_real    ));
+        case Type::TypeCode::Boolean : return Variant(_bool);
+        case Type::TypeCode::String  : return Variant(string());
+
+        /* containers only carry their type, enough for reporting type errors */
+        default:
+            return Variant(_type);
+    }
+}
+
+struct MessagePackBackend::Loader : public Variant::Loader
+{
+    size_t count;
+    const uint8_t *begin;
+    std::shared_ptr<const ByteSeq> source;
+
+public:
+    explicit Loader(const std::shared_ptr<const ByteSeq> &source, const uint8_t *begin, size_t count) :
+        count(count), begin(begin), source(source) {}
+
+public:
+    static Variant value(const std::shared_ptr<const ByteSeq> &source, const uint8_t *&p, const uint8_t *end)
+    {
+        const Tag &tag = Tags.tags[*p];
+        switch (tag.kind)
+        {
+            case TagKind::Map:
+            case TagKind::Array:
+            case TagKind::Object:
+            {
+                /* empty containers have nothing to defer */
+                size_t n = readLength(p, tag);
+                const uint8_t *items = p + tag.width + 1;
+
+                if (!n)
+                    break;
+
+                /* remember where the items are, then skip the whole container */
+                p = skip(p, end, 1);
+                return Variant(containerType(tag.kind), std::make_shared<Loader>(source, items, n));
+            }
+
+            default:
+                break;
+        }
+
+        /* scalars and strings are decoded immediately */
+        return decode(p, end);
+    }
+
+public:
+    virtual void load(Variant &value) const override
+    {
+        const uint8_t *p = begin;
+        const uint8_t *end = reinterpret_cast<const uint8_t *>(source->data()) + source->length();
+
+        switch (value.type())
+        {
+            case Type::TypeCode::Array:
+            {
+                /* reserve space to prevent frequent malloc */
+                Variant::Array &array = value.internalArray();
+                array.reserve(count);
+
+                /* items are deferred again */
+                for (size_t i = 0; i < count; i++)
+                    array.push_back(std::make_shared<Variant>(Loader::value(source, p, end)));
+
+                break;
+            }
+
+            case Type::TypeCode::Map:
+            {
+                /* keys are needed for hashing, thus decoded immediately */
+                for (size_t i = 0; i < count; i++)
+                {
+                    Variant key = decode(p, end);
+                    Variant item = Loader::value(source, p, end);
+
+                    /* add to map */
+                    value.internalMap().emplace(
+                        VariantHashKey(std::move(key)),
+                        std::make_shared<Variant>(std::move(item))
+                    );
+                }
+
+                break;
+            }
+
+            case Type::TypeCode::Object:
+            {
+                /* field names are strings */
+                for (size_t i = 0; i < count; i++)
+                {
+                    Variant key = decode(p, end);
+                    Variant item = Loader::value(source, p, end);
+
+                    /* add to object */
+                    value.internalObject().emplace(
+                        key.get<const std::string &>(),
+                        std::make_shared<Variant>(std::move(item))
+                    );
+                }
+
+                break;
+            }
+
+            default:
+            {
+                /* would NEVER happens */
+                abort();
+            }
+        }
+    }
+};
+
+Variant MessagePackBackend::parseLazy(ByteSeq &&data) const
+{
+    /* loaders share the ownership of buffer */
+    std::shared_ptr<const ByteSeq> source = std::make_shared<ByteSeq>(std::move(data));
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(source->data());
+    const uint8_t *end = p + source->length();
+
+    /* check bounds of the whole message once, so deferred decoding would never overflow */
+    skip(p, end, 1);
+    return Loader::value(source, p, end);
+}
+
 /* register backend into registry */
 defineBackend(MessagePackBackend)
+defineAltBackend(LazyMessagePackBackend)
+defineAltBackend(CanonicalMessagePackBackend)
 }
 }
@@ -0,0 +1,396 @@
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "Exceptions.h"
+#include "backend/Stages.h"
+
+namespace SimpleRPC
+{
+namespace Backends
+{
+/****** LZ4 block format ******/
+
+/* parameters from the LZ4 block format specification */
+static const size_t MinMatch     = 4;
+static const size_t LastLiterals = 5;
+static const size_t MatchLimit   = 12;
+static const size_t MaxOffset    = 65535;
+
+/* 4096 entries of hash table, fits in L1 cache */
+static const int HashLog = 12;
+
+/* stage methods */
+static const uint8_t MethodStored = 0;
+static const uint8_t MethodLZ4    = 1;
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t result;
+    memcpy(&result, p, sizeof(uint32_t));
+    return result;
+}
+
+static inline uint32_t hash32(uint32_t value)
+{
+    /* Knuth's multiplicative hash */
+    return (value * 2654435761u) >> (32 - HashLog);
+}
+
+static inline uint8_t *writeLength(uint8_t *op, size_t length)
+{
+    /* lengths beyond 15 are continued with 255-saturated bytes */
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+static inline uint8_t *writeLiterals(uint8_t *op, uint8_t *&token, const uint8_t *literals, size_t length)
+{
+    token = op++;
+
+    /* literal length in the high nibble */
+    if (length < 15)
+    {
+        *token = static_cast<uint8_t>(length << 4);
+    }
+    else
+    {
+        *token = 15 << 4;
+        op = writeLength(op, length - 15);
+    }
+
+    memcpy(op, literals, length);
+    return op + length;
+}
+
+static inline size_t readLength(const uint8_t *&ip, const uint8_t *end, size_t length)
+{
+    /* not extended */
+    if (length != 15)
+        return length;
+
+    /* add up all continuation bytes */
+    for (;;)
+    {
+        if (ip >= end)
+            throw Exceptions::DeserializerError("Truncated LZ4 block");
+
+        uint8_t byte = *ip++;
+        length += byte;
+
+        if (byte != 255)
+            return length;
+    }
+}
+
+size_t CompressionStage::compress(const void *src, size_t size, void *dest)
+{
+    uint8_t *op = reinterpret_cast<uint8_t *>(dest);
+    uint8_t *token = nullptr;
+
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+    const uint8_t *end = ip + size;
+    const uint8_t *base = ip;
+    const uint8_t *anchor = ip;
+
+    /* too short to have any matches */
+    if (size > MatchLimit)
+    {
+        uint32_t table[1 << HashLog] = {};
+        const uint8_t *mflimit = end - MatchLimit;
+        const uint8_t *matchlimit = end - LastLiterals;
+
+        while (ip <= mflimit)
+        {
+            /* find last position with the same hash */
+            uint32_t sequence = read32(ip);
+            uint32_t &slot = table[hash32(sequence)];
+            const uint8_t *ref = base + slot;
+
+            /* update hash table */
+            slot = static_cast<uint32_t>(ip - base);
+
+            /* not a match, skip faster when no matches were found for a while */
+            if ((ref >= ip) || (static_cast<size_t>(ip - ref) > MaxOffset) || (read32(ref) != sequence))
+            {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            /* extend the match forward */
+            const uint8_t *mp = ip + MinMatch;
+            const uint8_t *rp = ref + MinMatch;
+
+            while ((mp < matchlimit) && (*mp == *rp))
+            {
+                mp++;
+                rp++;
+            }
+
+            /* literals, then offset */
+            op = writeLiterals(op, token, anchor, ip - anchor);
+            *op++ = static_cast<uint8_t>((ip - ref) & 0xff);
+            *op++ = static_cast<uint8_t>((ip - ref) >> 8);
+
+            /* match length in the low nibble */
+            size_t length = mp - ip - MinMatch;
+
+            if (length < 15)
+            {
+                *token |= static_cast<uint8_t>(length);
+            }
+            else
+            {
+                *token |= 15;
+                op = writeLength(op, length - 15);
+            }
+
+            /* continue after the match */
+            ip = mp;
+            anchor = mp;
+        }
+    }
+
+    /* last sequence contains literals only */
+    op = writeLiterals(op, token, anchor, end - anchor);
+    return op - reinterpret_cast<uint8_t *>(dest);
+}
+
+void CompressionStage::decompress(const void *src, size_t size, void *dest, size_t length)
+{
+    uint8_t *op = reinterpret_cast<uint8_t *>(dest);
+    uint8_t *begin = op;
+    uint8_t *limit = op + length;
+
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+    const uint8_t *end = ip + size;
+
+    while (ip < end)
+    {
+        /* literals */
+        uint8_t token = *ip++;
+        size_t literals = readLength(ip, end, token >> 4);
+
+        if ((static_cast<size_t>(end - ip) < literals) || (static_cast<size_t>(limit - op) < literals))
+            throw Exceptions::DeserializerError("Invalid LZ4 literals");
+
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+
+        /* last sequence has no matches */
+        if (ip == end)
+            break;
+
+        /* match offset */
+        if (end - ip < 2)
+            throw Exceptions::DeserializerError("Truncated LZ4 block");
+
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if ((offset == 0) || (offset > static_cast<size_t>(op - begin)))
+            throw Exceptions::DeserializerError("Invalid LZ4 match offset");
+
+        /* match length */
+        size_t count = readLength(ip, end, token & 0x0f) + MinMatch;
+        const uint8_t *ref = op - offset;
+
+        if (static_cast<size_t>(limit - op) < count)
+            throw Exceptions::DeserializerError("Invalid LZ4 match length");
+
+        /* overlapped matches repeat the pattern, so they must be copied byte by byte */
+        if (offset >= count)
+        {
+            memcpy(op, ref, count);
+            op += count;
+        }
+        else
+        {
+            while (count--)
+                *op++ = *ref++;
+        }
+    }
+
+    /* must produce exactly the original data */
+    if (op != limit)
+        throw Exceptions::DeserializerError("LZ4 block length mismatch");
+}
+
+ByteSeq CompressionStage::encode(ByteSeq &&data) const
+{
+    size_t size = data.length();
+
+    /* large enough to be worth compressing */
+    if ((size >= _threshold) && (size <= UINT32_MAX))
+    {
+        ByteSeq result;
+        char *p = result.preserve(compressBound(size) + sizeof(uint32_t) + sizeof(uint8_t));
+        size_t length = compress(data.data(), size, p);
+
+        /* only if it actually shrinks */
+        if (length + sizeof(uint32_t) + sizeof(uint8_t) < size)
+        {
+            result.commit(length);
+            result.appendLE(static_cast<uint32_t>(size));
+            result.appendLE(MethodLZ4);
+            return result;
+        }
+    }
+
+    /* stored as is */
+    data.appendLE(MethodStored);
+    return std::move(data);
+}
+
+ByteSeq CompressionStage::decode(ByteSeq &&data) const
+{
+    size_t size = data.length();
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data.data());
+
+    /* method byte at the end */
+    if (size < sizeof(uint8_t))
+        throw Exceptions::DeserializerError("Missing compression method");
+
+    switch (p[size - 1])
+    {
+        case MethodStored:
+        {
+            data.truncate(size - sizeof(uint8_t));
+            return std::move(data);
+        }
+
+        case MethodLZ4:
+        {
+            uint32_t length;
+
+            /* raw length before the method byte */
+            if (size < sizeof(uint32_t) + sizeof(uint8_t))
+                throw Exceptions::DeserializerError("Missing raw length");
+
+            size -= sizeof(uint32_t) + sizeof(uint8_t);
+            memcpy(&length, p + size, sizeof(uint32_t));
+
+            /* every byte of input produces at most 255 bytes of output, reject before allocating */
+            if (length > size * 255)
+                throw Exceptions::DeserializerError("Raw length is too large");
+
+            ByteSeq result;
+            decompress(p, size, result.preserve(length), length);
+            result.commit(length);
+            return result;
+        }
+
+        default:
+            throw Exceptions::DeserializerError("Unknown compression method " + std::to_string(p[size - 1]));
+    }
+}
+
+/****** CRC32C (Castagnoli) ******/
+
+struct CRCTable
+{
+    uint32_t entries[256];
+};
+
+static constexpr CRCTable makeCRCTable(void)
+{
+    CRCTable table {};
+
+    /* reflected polynomial 0x1EDC6F41 */
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78u : 0);
+
+        table.entries[i] = crc;
+    }
+
+    return table;
+}
+
+static constexpr CRCTable CRCs = makeCRCTable();
+
+static uint32_t crc32cSoftware(const uint8_t *p, size_t size, uint32_t crc)
+{
+    while (size--)
+        crc = CRCs.entries[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(const uint8_t *p, size_t size, uint32_t crc)
+{
+    uint64_t value = crc;
+
+    /* 8 bytes at a time */
+    while (size >= sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(uint64_t));
+        value = _mm_crc32_u64(value, word);
+        p += sizeof(uint64_t);
+        size -= sizeof(uint64_t);
+    }
+
+    /* the remaining bytes */
+    crc = static_cast<uint32_t>(value);
+    while (size--)
+        crc = _mm_crc32_u8(crc, *p++);
+
+    return crc;
+}
+#endif
+
+uint32_t ChecksumStage::crc32c(const void *data, size_t size, uint32_t crc)
+{
+#if defined(__x86_64__)
+    /* detect CPU features only once */
+    static const auto impl = __builtin_cpu_supports("sse4.2") ? crc32cHardware : crc32cSoftware;
+#else
+    static const auto impl = crc32cSoftware;
+#endif
+
+    /* pre- and post-inverted, so `crc` can be chained across calls */
+    return ~impl(reinterpret_cast<const uint8_t *>(data), size, ~crc);
+}
+
+ByteSeq ChecksumStage::encode(ByteSeq &&data) const
+{
+    data.appendLE(crc32c(data.data(), data.length()));
+    return std::move(data);
+}
+
+ByteSeq ChecksumStage::decode(ByteSeq &&data) const
+{
+    uint32_t crc;
+    size_t size = data.length();
+
+    /* checksum at the end */
+    if (size < sizeof(uint32_t))
+        throw Exceptions::DeserializerError("Missing checksum");
+
+    size -= sizeof(uint32_t);
+    memcpy(&crc, data.data() + size, sizeof(uint32_t));
+
+    /* verify against payload */
+    if (crc != crc32c(data.data(), size))
+        throw Exceptions::DeserializerError("Checksum mismatch");
+
+    data.truncate(size);
+    return std::move(data);
+}
+}
+}
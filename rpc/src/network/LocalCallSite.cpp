@@ -28,19 +28,89 @@ Variant LocalCallSite::invoke(size_t id, const std::string &name, const std::str
     return iter->second->invoke(object->second.get(), args);
 }
 
+void LocalCallSite::setPoolSize(const std::string &name, size_t limit, Reset reset)
+{
+    Pool &pool = _pools[&Registry::findClass(name)];
+
+    /* drop objects beyond the new limit */
+    if (pool.objects.size() > limit)
+        pool.objects.resize(limit);
+
+    /* reserve all the space, so `cleanup` never allocates */
+    pool.limit = limit;
+    pool.reset = reset;
+    pool.objects.reserve(limit);
+}
+
 void LocalCallSite::cleanup(size_t id) noexcept
 {
-    /* just erase from registry, `std::unique_ptr` will free the object */
-    _objects.erase(id);
+    auto object = _objects.find(id);
+
+    /* not registered, nothing to clean */
+    if (object == _objects.end())
+        return;
+
+    /* keep it for later use if the pool has room, otherwise `std::unique_ptr` will free the object */
+    auto pool = _pools.find(&object->second->meta());
+    if ((pool != _pools.end()) && (pool->second.objects.size() < pool->second.limit))
+        pool->second.objects.push_back(std::move(object->second));
+
+    /* erase from registry */
+    _objects.erase(object);
 }
 
 size_t LocalCallSite::startup(const std::string &name)
 {
-    size_t newId = __sync_fetch_and_add(&_id, 1);
+    /* find the class and create one */
+    return instantiate(Registry::findClass(name));
+}
+
+std::vector<size_t> LocalCallSite::startupMany(const std::string &name, size_t count)
+{
+    std::vector<size_t> ids;
     const auto &meta = Registry::findClass(name);
 
-    /* instaniate object and register into object map */
-    _objects.emplace(newId, std::unique_ptr<Serializable>(meta.newInstance<Serializable>()));
+    /* class is looked up only once, and the object map grows only once */
+    ids.reserve(count);
+    _objects.reserve(_objects.size() + count);
+
+    try
+    {
+        for (size_t i = 0; i < count; i++)
+            ids.push_back(instantiate(meta));
+    }
+    catch (...)
+    {
+        /* don't leave half of them behind */
+        cleanupMany(ids);
+        throw;
+    }
+
+    return ids;
+}
+
+size_t LocalCallSite::instantiate(Registry::MetaClass meta)
+{
+    size_t newId = __sync_fetch_and_add(&_id, 1);
+    auto pool = _pools.find(&meta);
+
+    /* no recycled objects, instaniate a new one and register into object map */
+    if ((pool == _pools.end()) || pool->second.objects.empty())
+    {
+        _objects.emplace(newId, std::unique_ptr<Serializable>(meta.newInstance<Serializable>()));
+        return newId;
+    }
+
+    /* take one from the pool */
+    std::unique_ptr<Serializable> object = std::move(pool->second.objects.back());
+    pool->second.objects.pop_back();
+
+    /* reset before reuse */
+    if (pool->second.reset)
+        pool->second.reset(object.get());
+
+    /* register into object map */
+    _objects.emplace(newId, std::move(object));
     return newId;
 }
 }